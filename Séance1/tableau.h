@@ -0,0 +1,471 @@
+/*
+* outils communs aux programmes de tri de la Séance 1 (tri_insertion, tri_rapide, tri_radix,
+* tri_fusion) : chaque programme définit NOM_ALGORITHME et trierBanc, inclut ce fichier et en a
+* sa propre copie (fonctions static), ce qui garde chaque programme compilable seul
+*/
+#ifndef TABLEAU_H
+#define TABLEAU_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// nombre d'éléments par défaut (OPTION_TAILLE pour le changer) : le tableau est alloué à
+// l'exécution, ou projeté en mémoire depuis un fichier binaire d'int natifs (OPTION_ENTREE)
+// qui est alors trié sur place
+#define TAILLE 300000
+#define OPTION_TAILLE "--taille"
+#define OPTION_ENTREE "--entree"
+// les grands tableaux sont alignés sur une grande page et, si possible, faits de grandes pages
+#define TAILLE_GRANDE_PAGE (2UL << 20)
+typedef int tableau[];
+
+// générateur pseudo-aléatoire xoshiro128** à graine explicite : NB_VOIES copies du générateur,
+// espacées de 2^64 tirages, avancent ensemble pour que le remplissage soit vectorisé
+#define NB_VOIES 8
+#define GRAINE 1
+
+typedef struct {
+    uint32_t s[4][NB_VOIES];
+} tGenerateur;
+
+static tGenerateur generateur;
+
+// sortie du tableau : texte (entiers séparés par separateur), binaire (int natifs) ou
+// seulement vérification que le tableau est trié, choisie sur la ligne de commande
+#define OPTION_BINAIRE "--binaire"
+#define OPTION_SEPARATEUR "--separateur"
+#define OPTION_VERIFIER "--verifier"
+#define SORTIE_TEXTE 0
+#define SORTIE_BINAIRE 1
+#define SORTIE_VERIFICATION 2
+// le texte est formaté dans un tampon de TAILLE_TAMPON_SORTIE octets vidé par write() ;
+// un entier et son séparateur font au plus LONGUEUR_MAX_ENTIER caractères
+#define TAILLE_TAMPON_SORTIE (1 << 16)
+#define LONGUEUR_MAX_ENTIER 12
+
+static int modeSortie = SORTIE_TEXTE;
+static char separateur = '\n';
+
+// banc d'essai (OPTION_BANC) : pour chaque distribution et chaque taille de TAILLE_MIN_BANC
+// à tailleMaxBanc (puissances de 10), NB_ECHAUFFEMENTS tris non mesurés puis entre
+// NB_MESURES_MIN et NB_MESURES_MAX tris chronométrés, environ ELEMENTS_PAR_TAILLE éléments
+// triés en tout ; seul le tri est mesuré. Résultats en CSV sur la sortie standard
+#define OPTION_BANC "--banc"
+#define OPTION_TAILLE_MAX "--taille-max"
+#define TAILLE_MIN_BANC 1000
+#define TAILLE_MAX_BANC 100000000
+#define NB_ECHAUFFEMENTS 1
+#define NB_MESURES_MIN 3
+#define NB_MESURES_MAX 21
+#define ELEMENTS_PAR_TAILLE 20000000
+#define NB_DISTRIBUTIONS 5
+#define DISTRIBUTION_ALEATOIRE 0
+#define DISTRIBUTION_TRIEE 1
+#define DISTRIBUTION_INVERSEE 2
+#define DISTRIBUTION_PEU_DISTINCTS 3
+#define DISTRIBUTION_TUYAUX_ORGUE 4
+// nombre de valeurs différentes de DISTRIBUTION_PEU_DISTINCTS
+#define NB_VALEURS_PEU_DISTINCTS 16
+
+static const char *NOMS_DISTRIBUTIONS[NB_DISTRIBUTIONS] = {"aleatoire", "trie", "inverse", "peu_distincts", "tuyaux_orgue"};
+static long tailleMaxBanc = TAILLE_MAX_BANC;
+
+static uint64_t splitmix64(uint64_t *etat);
+static uint32_t rotation(uint32_t x, int k);
+static uint32_t suivantXoshiro(uint32_t s[4]);
+static void sauterXoshiro(uint32_t s[4]);
+static void initGenerateur(tGenerateur *g, uint64_t graine, int flux);
+static void remplirAleatoire(tGenerateur *g, int T[], int n);
+static void genereTableau(tableau T, int n);
+static void afficheTableau(tableau T, int n);
+static int verifieTableau(tableau T, int n);
+static int premiereInversion(int T[], int n);
+static int formaterEntier(int x, char *texte);
+static void ecrireTout(int fd, const char *donnees, size_t taille);
+static int *allouerTableau(size_t n);
+static void libererTableau(int *T, size_t n);
+static int *projeterFichier(const char *nom, int *n);
+static void libererProjection(int *T, int n);
+static void bancEssai();
+// tri mesuré par le banc d'essai, propre à chaque programme
+void trierBanc(int T[], int n);
+static void genereDistribution(int T[], int n, int distribution);
+static double chronometre(clockid_t horloge);
+static int compareDoubles(const void *a, const void *b);
+
+static uint64_t splitmix64(uint64_t *etat){
+    // sert seulement à étaler la graine sur les 128 bits d'état du générateur
+    uint64_t z = (*etat += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static uint32_t rotation(uint32_t x, int k){
+    return (x << k) | (x >> (32 - k));
+}
+
+static uint32_t suivantXoshiro(uint32_t s[4]){
+    uint32_t resultat = rotation(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotation(s[3], 11);
+    return resultat;
+}
+
+static void sauterXoshiro(uint32_t s[4]){
+    // avance l'état de 2^64 tirages (polynôme de saut de xoshiro128**)
+    static const uint32_t SAUT[4] = {0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b};
+    uint32_t r[4] = {0, 0, 0, 0};
+    for (int i = 0 ; i < 4 ; i++){
+        for (int b = 0 ; b < 32 ; b++){
+            if (SAUT[i] & ((uint32_t)1 << b)){
+                for (int k = 0 ; k < 4 ; k++){
+                    r[k] ^= s[k];
+                }
+            }
+            suivantXoshiro(s);
+        }
+    }
+    for (int k = 0 ; k < 4 ; k++){
+        s[k] = r[k];
+    }
+}
+
+static void initGenerateur(tGenerateur *g, uint64_t graine, int flux){
+    /*
+    * chaque flux (un par thread par exemple) part d'un état tiré de la graine et de son
+    * numéro : deux générateurs de même graine et de même flux donnent la même suite.
+    * Les voies d'un flux sont des sauts successifs de 2^64 tirages
+    */
+    uint64_t etat = graine ^ ((uint64_t)flux * 0xd1b54a32d192ed03ULL);
+    uint32_t s[4];
+    do {
+        uint64_t a = splitmix64(&etat);
+        uint64_t b = splitmix64(&etat);
+        s[0] = (uint32_t)a;
+        s[1] = (uint32_t)(a >> 32);
+        s[2] = (uint32_t)b;
+        s[3] = (uint32_t)(b >> 32);
+    } while ((s[0] | s[1] | s[2] | s[3]) == 0);
+    for (int v = 0 ; v < NB_VOIES ; v++){
+        for (int k = 0 ; k < 4 ; k++){
+            g->s[k][v] = s[k];
+        }
+        sauterXoshiro(s);
+    }
+}
+
+static void remplirAleatoire(tGenerateur *g, int T[], int n){
+    /*
+    * remplit T d'entiers entre 0 et 2^31 - 1, comme rand() : chaque étape tire une valeur
+    * par voie, les voies étant indépendantes la boucle sur v est vectorisable. Une fin de
+    * tableau plus courte que NB_VOIES consomme quand même une étape entière
+    */
+    uint32_t s0[NB_VOIES], s1[NB_VOIES], s2[NB_VOIES], s3[NB_VOIES], tirage[NB_VOIES];
+    memcpy(s0, g->s[0], sizeof(s0));
+    memcpy(s1, g->s[1], sizeof(s1));
+    memcpy(s2, g->s[2], sizeof(s2));
+    memcpy(s3, g->s[3], sizeof(s3));
+    for (int i = 0 ; i < n ; i += NB_VOIES){
+        for (int v = 0 ; v < NB_VOIES ; v++){
+            tirage[v] = rotation(s1[v] * 5, 7) * 9;
+            uint32_t t = s1[v] << 9;
+            s2[v] ^= s0[v];
+            s3[v] ^= s1[v];
+            s1[v] ^= s2[v];
+            s0[v] ^= s3[v];
+            s2[v] ^= t;
+            s3[v] = rotation(s3[v], 11);
+        }
+        int nombre = (n - i < NB_VOIES) ? n - i : NB_VOIES;
+        for (int v = 0 ; v < nombre ; v++){
+            T[i + v] = (int)(tirage[v] >> 1);
+        }
+    }
+    memcpy(g->s[0], s0, sizeof(s0));
+    memcpy(g->s[1], s1, sizeof(s1));
+    memcpy(g->s[2], s2, sizeof(s2));
+    memcpy(g->s[3], s3, sizeof(s3));
+}
+
+static void genereTableau(tableau T, int n){
+    remplirAleatoire(&generateur, T, n);
+}
+
+static void afficheTableau(tableau T, int n){
+    /*
+    * en texte, les entiers sont formatés à la main dans un tampon écrit par write() dès
+    * qu'il est plein ; en binaire, le tableau est écrit tel qu'il est en mémoire
+    */
+    static char tampon[TAILLE_TAMPON_SORTIE];
+    size_t rempli = 0;
+    if (modeSortie == SORTIE_BINAIRE){
+        ecrireTout(STDOUT_FILENO, (const char *)T, (size_t)n * sizeof(int));
+        return;
+    }
+    for (int i = 0 ; i < n ; i++){
+        if (rempli > TAILLE_TAMPON_SORTIE - LONGUEUR_MAX_ENTIER){
+            ecrireTout(STDOUT_FILENO, tampon, rempli);
+            rempli = 0;
+        }
+        rempli += formaterEntier(T[i], tampon + rempli);
+        tampon[rempli++] = separateur;
+    }
+    ecrireTout(STDOUT_FILENO, tampon, rempli);
+}
+
+static int verifieTableau(tableau T, int n){
+    // remplace l'affichage : dit si le tableau est trié, sinon où est la première inversion
+    int i = premiereInversion(T, n);
+    if (i != 0){
+        printf("tableau non trié : T[%d] = %d > T[%d] = %d\n", i - 1, T[i - 1], i, T[i]);
+        return 0;
+    }
+    printf("tableau trié (%d éléments)\n", n);
+    return 1;
+}
+
+static int premiereInversion(int T[], int n){
+    // indice i du premier T[i - 1] > T[i], 0 si T est trié
+    for (int i = 1 ; i < n ; i++){
+        if (T[i - 1] > T[i]){
+            return i;
+        }
+    }
+    return 0;
+}
+
+static int formaterEntier(int x, char *texte){
+    // écrit x en décimal dans texte, sans zéro final, deux chiffres à la fois depuis la fin ;
+    // retourne le nombre de caractères écrits
+    static const char DEUX_CHIFFRES[] =
+        "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+        "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+    char chiffres[10];
+    int debut = 10;
+    int longueur = 0;
+    unsigned int u = (x < 0) ? 0u - (unsigned int)x : (unsigned int)x;
+    while (u >= 100){
+        unsigned int reste = u % 100;
+        u /= 100;
+        debut -= 2;
+        memcpy(&chiffres[debut], &DEUX_CHIFFRES[2 * reste], 2);
+    }
+    if (u >= 10){
+        debut -= 2;
+        memcpy(&chiffres[debut], &DEUX_CHIFFRES[2 * u], 2);
+    } else {
+        chiffres[--debut] = (char)('0' + u);
+    }
+    if (x < 0){
+        texte[longueur++] = '-';
+    }
+    memcpy(texte + longueur, &chiffres[debut], (size_t)(10 - debut));
+    return longueur + 10 - debut;
+}
+
+static void ecrireTout(int fd, const char *donnees, size_t taille){
+    // write() peut n'écrire qu'une partie des données ou être interrompu par un signal
+    while (taille > 0){
+        ssize_t ecrit = write(fd, donnees, taille);
+        if (ecrit < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            perror("write");
+            exit(EXIT_FAILURE);
+        }
+        donnees += ecrit;
+        taille -= (size_t)ecrit;
+    }
+}
+
+static int *allouerTableau(size_t n){
+    /*
+    * zone anonyme arrondie à un nombre entier de grandes pages : d'abord en grandes pages
+    * réservées (MAP_HUGETLB), sinon alignée sur une grande page pour que le noyau puisse la
+    * remplir de grandes pages transparentes. Un tableau plus petit qu'une grande page est
+    * simplement alloué par malloc
+    */
+    if (n * sizeof(int) < TAILLE_GRANDE_PAGE){
+        int *T = malloc(n * sizeof(int) + 1);
+        if (T == NULL){
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        return T;
+    }
+    size_t taille = (n * sizeof(int) + TAILLE_GRANDE_PAGE - 1) / TAILLE_GRANDE_PAGE * TAILLE_GRANDE_PAGE;
+    void *zone = mmap(NULL, taille, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (zone != MAP_FAILED){
+        return zone;
+    }
+    char *brut = mmap(NULL, taille + TAILLE_GRANDE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (brut == MAP_FAILED){
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    // on rend au noyau ce qui dépasse avant et après la partie alignée
+    char *debut = (char *)(((uintptr_t)brut + TAILLE_GRANDE_PAGE - 1) & ~(uintptr_t)(TAILLE_GRANDE_PAGE - 1));
+    if (debut > brut){
+        munmap(brut, (size_t)(debut - brut));
+    }
+    munmap(debut + taille, (size_t)(brut + TAILLE_GRANDE_PAGE - debut));
+    madvise(debut, taille, MADV_HUGEPAGE);
+    return (int *)debut;
+}
+
+static void libererTableau(int *T, size_t n){
+    if (n * sizeof(int) < TAILLE_GRANDE_PAGE){
+        free(T);
+        return;
+    }
+    munmap(T, (n * sizeof(int) + TAILLE_GRANDE_PAGE - 1) / TAILLE_GRANDE_PAGE * TAILLE_GRANDE_PAGE);
+}
+
+static int *projeterFichier(const char *nom, int *n){
+    // projection partagée : le tri écrit directement dans le fichier, sans copie
+    int fd = open(nom, O_RDWR);
+    struct stat etat;
+    if (fd < 0 || fstat(fd, &etat) < 0){
+        perror(nom);
+        exit(EXIT_FAILURE);
+    }
+    if (etat.st_size % (off_t)sizeof(int) != 0 || etat.st_size / (off_t)sizeof(int) > INT_MAX){
+        fprintf(stderr, "%s : taille incorrecte pour un tableau d'int\n", nom);
+        exit(EXIT_FAILURE);
+    }
+    *n = (int)(etat.st_size / (off_t)sizeof(int));
+    int *T = NULL;
+    if (*n > 0){
+        T = mmap(NULL, (size_t)etat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (T == MAP_FAILED){
+            perror("mmap");
+            exit(EXIT_FAILURE);
+        }
+        madvise(T, (size_t)etat.st_size, MADV_WILLNEED);
+    }
+    close(fd);
+    return T;
+}
+
+static void libererProjection(int *T, int n){
+    if (T != NULL){
+        munmap(T, (size_t)n * sizeof(int));
+    }
+}
+
+static void bancEssai(){
+    /*
+    * chaque tri part d'une copie du même tableau d'origine ; un tableau mal trié arrête
+    * le banc. La colonne cpu (CLOCK_PROCESS_CPUTIME_ID) compte le temps de tous les threads.
+    * Les tableaux sont alloués à chaque taille, hors mesure : les petites tailles ne réservent
+    * pas la mémoire de la plus grande
+    */
+    double mesures[NB_MESURES_MAX];
+    double mesuresCpu[NB_MESURES_MAX];
+    printf("algorithme,distribution,taille,mesures,mediane_ns_par_element,p95_ns_par_element,cpu_mediane_ns_par_element\n");
+    for (int distribution = 0 ; distribution < NB_DISTRIBUTIONS ; distribution++){
+        for (long taille = TAILLE_MIN_BANC ; taille <= tailleMaxBanc ; taille *= 10){
+            int n = (int)taille;
+            long nbMesures = ELEMENTS_PAR_TAILLE / taille;
+            if (nbMesures < NB_MESURES_MIN){
+                nbMesures = NB_MESURES_MIN;
+            } else if (nbMesures > NB_MESURES_MAX){
+                nbMesures = NB_MESURES_MAX;
+            }
+            int *original = allouerTableau((size_t)n);
+            int *travail = allouerTableau((size_t)n);
+            genereDistribution(original, n, distribution);
+            for (int r = -NB_ECHAUFFEMENTS ; r < nbMesures ; r++){
+                memcpy(travail, original, (size_t)n * sizeof(int));
+                double debut = chronometre(CLOCK_MONOTONIC);
+                double debutCpu = chronometre(CLOCK_PROCESS_CPUTIME_ID);
+                trierBanc(travail, n);
+                double duree = chronometre(CLOCK_MONOTONIC) - debut;
+                double dureeCpu = chronometre(CLOCK_PROCESS_CPUTIME_ID) - debutCpu;
+                int inversion = premiereInversion(travail, n);
+                if (inversion != 0){
+                    fprintf(stderr, "%s : tableau %s de %d éléments mal trié en %d\n",
+                            NOM_ALGORITHME, NOMS_DISTRIBUTIONS[distribution], n, inversion);
+                    exit(EXIT_FAILURE);
+                }
+                if (r >= 0){
+                    mesures[r] = duree / n;
+                    mesuresCpu[r] = dureeCpu / n;
+                }
+            }
+            qsort(mesures, (size_t)nbMesures, sizeof(double), compareDoubles);
+            qsort(mesuresCpu, (size_t)nbMesures, sizeof(double), compareDoubles);
+            // 95e centile au rang le plus proche
+            long rangP95 = (95 * nbMesures + 99) / 100 - 1;
+            printf("%s,%s,%d,%ld,%.3f,%.3f,%.3f\n", NOM_ALGORITHME, NOMS_DISTRIBUTIONS[distribution], n,
+                   nbMesures, mesures[nbMesures / 2], mesures[rangP95], mesuresCpu[nbMesures / 2]);
+            fflush(stdout);
+            libererTableau(original, (size_t)n);
+            libererTableau(travail, (size_t)n);
+        }
+    }
+}
+
+static void genereDistribution(int T[], int n, int distribution){
+    // les tirages aléatoires ont leur propre flux par distribution : le banc est reproductible
+    tGenerateur g;
+    initGenerateur(&g, GRAINE, distribution + 1);
+    switch (distribution){
+        case DISTRIBUTION_ALEATOIRE:
+            remplirAleatoire(&g, T, n);
+            break;
+        case DISTRIBUTION_TRIEE:
+            for (int i = 0 ; i < n ; i++){
+                T[i] = i;
+            }
+            break;
+        case DISTRIBUTION_INVERSEE:
+            for (int i = 0 ; i < n ; i++){
+                T[i] = n - i;
+            }
+            break;
+        case DISTRIBUTION_PEU_DISTINCTS:
+            remplirAleatoire(&g, T, n);
+            for (int i = 0 ; i < n ; i++){
+                T[i] %= NB_VALEURS_PEU_DISTINCTS;
+            }
+            break;
+        case DISTRIBUTION_TUYAUX_ORGUE:
+            // croissant jusqu'au milieu puis décroissant
+            for (int i = 0 ; i < n ; i++){
+                T[i] = (i < n / 2) ? i : n - i;
+            }
+            break;
+    }
+}
+
+static double chronometre(clockid_t horloge){
+    // temps de l'horloge en nanosecondes
+    struct timespec t;
+    clock_gettime(horloge, &t);
+    return (double)t.tv_sec * 1e9 + (double)t.tv_nsec;
+}
+
+static int compareDoubles(const void *a, const void *b){
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+#endif
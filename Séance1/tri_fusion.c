@@ -0,0 +1,564 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+// nom de l'algorithme dans les résultats du banc d'essai
+#define NOM_ALGORITHME "tri_fusion"
+#include "tableau.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AVEC_AVX2
+#endif
+
+// tri fusion : les blocs de TAILLE_BLOC entiers sont triés par un réseau de tri, puis les
+// suites voisines sont fusionnées deux à deux, du tableau vers un tampon et inversement,
+// jusqu'à n'en avoir plus qu'une : O(n log n) dans tous les cas. Les réseaux min/max ne
+// gardent pas l'ordre des égaux, ce qui ne se voit pas sur des int seuls ; la variante
+// stable (OPTION_STABLE) trie des couples clé/charge par insertion puis fusion scalaire
+#define TAILLE_BLOC 16
+#define OPTION_STABLE "--stable"
+// au-dessus de SEUIL_PARALLELE éléments, chaque passe est partagée entre les threads
+#define SEUIL_PARALLELE 65536
+#define NB_THREADS_MAX 64
+
+// comparateurs d'un réseau de tri sur 8 entiers : v est comparé à p (v permuté), chaque
+// entier dont le bit est à 1 dans masque garde le plus grand des deux, les autres le plus petit
+#define COMPARER_ECHANGER(v, p, masque) _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), masque)
+
+// élément du tri stable : la clé comparée et la charge qui la suit (ici sa position d'origine)
+typedef struct {
+    int cle;
+    int charge;
+} tElement;
+
+// état du tri parallèle en cours, partagé par les threads
+pthread_t threads[NB_THREADS_MAX];
+int ids[NB_THREADS_MAX];
+pthread_barrier_t barriere;
+int *tableauTri;
+int *tamponTri;
+// tri stable en cours, NULL pour le tri des int
+tElement *elementsTri;
+tElement *tamponElements;
+int tailleTri;
+int nbThreads = 1;
+// le processeur a-t-il AVX2 (vérifié à l'exécution)
+int avx2Disponible = 0;
+
+void triFusion(tableau T, int n);
+void trierFusion(int T[], int n);
+void triFusionStable(tElement T[], int n);
+void lancerPasses();
+void *travailleurFusion(void *arg);
+void passesFusion(int id, int nb);
+void passesFusionStable(int id, int nb);
+int verifieStabilite(const tElement T[], int n);
+int coRangStable(int d, const tElement A[], int nA, const tElement B[], int nB);
+void trierBlocStable(tElement T[], int n);
+void fusionnerStable(const tElement A[], int nA, const tElement B[], int nB, tElement sortie[]);
+int coRang(int d, const int A[], int nA, const int B[], int nB);
+void trierBloc(int T[], int n);
+void fusionner(const int A[], int nA, const int B[], int nB, int sortie[]);
+void fusionnerScalaire(const int A[], int nA, const int B[], int nB, int sortie[]);
+void trierBlocAvx2(int T[]);
+void fusionnerAvx2(const int A[], int nA, const int B[], int nB, int sortie[]);
+
+int main(int argc, char *argv[]){
+    int banc = 0;
+    int stable = 0;
+    int n = TAILLE;
+    const char *entree = NULL;
+    int *T;
+    for (int i = 1 ; i < argc ; i++){
+        if (strcmp(argv[i], OPTION_BINAIRE) == 0){
+            modeSortie = SORTIE_BINAIRE;
+        } else if (strcmp(argv[i], OPTION_VERIFIER) == 0){
+            modeSortie = SORTIE_VERIFICATION;
+        } else if (strcmp(argv[i], OPTION_SEPARATEUR) == 0 && i + 1 < argc && argv[i + 1][0] != '\0'){
+            separateur = argv[++i][0];
+        } else if (strcmp(argv[i], OPTION_BANC) == 0){
+            banc = 1;
+        } else if (strcmp(argv[i], OPTION_STABLE) == 0){
+            stable = 1;
+        } else if (strcmp(argv[i], OPTION_TAILLE_MAX) == 0 && i + 1 < argc){
+            tailleMaxBanc = atol(argv[++i]);
+        } else if (strcmp(argv[i], OPTION_TAILLE) == 0 && i + 1 < argc){
+            n = atoi(argv[++i]);
+        } else if (strcmp(argv[i], OPTION_ENTREE) == 0 && i + 1 < argc){
+            entree = argv[++i];
+        }
+    }
+    if (n < 0){
+        n = 0;
+    }
+    nbThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nbThreads < 1){
+        nbThreads = 1;
+    } else if (nbThreads > NB_THREADS_MAX){
+        nbThreads = NB_THREADS_MAX;
+    }
+    if (banc){
+        bancEssai();
+        return EXIT_SUCCESS;
+    }
+    if (entree != NULL){
+        T = projeterFichier(entree, &n);
+    } else {
+        T = allouerTableau((size_t)n);
+        initGenerateur(&generateur, GRAINE, 0);
+        genereTableau(T, n);
+    }
+    // tri stable : chaque entier part avec sa position, retrouvée dans l'ordre à égalité
+    tElement *E = NULL;
+    if (stable){
+        E = (tElement *)allouerTableau(2 * (size_t)n);
+        for (int i = 0 ; i < n ; i++){
+            E[i].cle = T[i];
+            E[i].charge = i;
+        }
+    }
+    double debutTri = chronometre(CLOCK_MONOTONIC);
+    if (stable){
+        triFusionStable(E, n);
+    } else {
+        triFusion(T, n);
+    }
+    double dureeTri = chronometre(CLOCK_MONOTONIC) - debutTri;
+    if (stable){
+        for (int i = 0 ; i < n ; i++){
+            T[i] = E[i].cle;
+        }
+    }
+    int resultat = EXIT_SUCCESS;
+    if (modeSortie == SORTIE_VERIFICATION){
+        if (!verifieTableau(T, n) || (stable && !verifieStabilite(E, n))){
+            resultat = EXIT_FAILURE;
+        }
+    } else {
+        afficheTableau(T, n);
+    }
+    // sur la sortie d'erreur, pour ne pas se mêler au tableau
+    fprintf(stderr, "durée du tri : %.3f ms\n", dureeTri / 1e6);
+    if (stable){
+        libererTableau((int *)E, 2 * (size_t)n);
+    }
+    if (entree != NULL){
+        libererProjection(T, n);
+    } else {
+        libererTableau(T, (size_t)n);
+    }
+    return resultat;
+}
+
+void triFusion(tableau T, int n){
+    trierFusion(T, n);
+}
+
+void trierFusion(int T[], int n){
+    if (n < 2){
+        return;
+    }
+#ifdef AVEC_AVX2
+    avx2Disponible = __builtin_cpu_supports("avx2");
+#endif
+    tableauTri = T;
+    tamponTri = allouerTableau((size_t)n);
+    tailleTri = n;
+    lancerPasses();
+    libererTableau(tamponTri, (size_t)n);
+}
+
+void triFusionStable(tElement T[], int n){
+    // mêmes passes que trierFusion, sur des couples clé/charge et sans réseau de tri
+    if (n < 2){
+        return;
+    }
+    elementsTri = T;
+    tamponElements = (tElement *)allouerTableau(2 * (size_t)n);
+    tailleTri = n;
+    lancerPasses();
+    libererTableau((int *)tamponElements, 2 * (size_t)n);
+    elementsTri = NULL;
+}
+
+void lancerPasses(){
+    // le thread principal est le travailleur 0 ; sans autre thread, il fait toutes les passes
+    if (nbThreads <= 1 || tailleTri < SEUIL_PARALLELE){
+        if (elementsTri != NULL){
+            passesFusionStable(0, 1);
+        } else {
+            passesFusion(0, 1);
+        }
+        return;
+    }
+    pthread_barrier_init(&barriere, NULL, (unsigned int)nbThreads);
+    for (int i = 0 ; i < nbThreads ; i++){
+        ids[i] = i;
+    }
+    for (int i = 1 ; i < nbThreads ; i++){
+        if (pthread_create(&threads[i], NULL, travailleurFusion, &ids[i]) != 0){
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    travailleurFusion(&ids[0]);
+    for (int i = 1 ; i < nbThreads ; i++){
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&barriere);
+}
+
+void *travailleurFusion(void *arg){
+    if (elementsTri != NULL){
+        passesFusionStable(*(int *)arg, nbThreads);
+    } else {
+        passesFusion(*(int *)arg, nbThreads);
+    }
+    return NULL;
+}
+
+void passesFusion(int id, int nb){
+    /*
+    * travail du thread id parmi nb : sa part des blocs, puis à chaque passe sa part de la
+    * sortie. La sortie d'une passe est coupée en nb parts égales quelles que soient les
+    * paires de suites qu'elles recouvrent : dans chaque paire, les co-rangs des deux bouts
+    * de la part (partage du chemin de fusion) donnent les morceaux des deux suites à fusionner.
+    * Les barrières séparent les passes
+    */
+    int n = tailleTri;
+    int *source = tableauTri;
+    int *destination = tamponTri;
+    int nbBlocs = (n + TAILLE_BLOC - 1) / TAILLE_BLOC;
+
+    for (long b = (long)nbBlocs * id / nb ; b < (long)nbBlocs * (id + 1) / nb ; b++){
+        int debut = (int)b * TAILLE_BLOC;
+        trierBloc(source + debut, (n - debut < TAILLE_BLOC) ? n - debut : TAILLE_BLOC);
+    }
+    if (nb > 1){
+        pthread_barrier_wait(&barriere);
+    }
+
+    for (long largeur = TAILLE_BLOC ; largeur < n ; largeur *= 2){
+        int debutPart = (int)((long)n * id / nb);
+        int finPart = (int)((long)n * (id + 1) / nb);
+        int k = debutPart;
+        while (k < finPart){
+            int debutPaire = (int)(k / (2 * largeur) * (2 * largeur));
+            int milieu = (int)((debutPaire + largeur < n) ? debutPaire + largeur : n);
+            int finPaire = (int)((debutPaire + 2 * largeur < n) ? debutPaire + 2 * largeur : n);
+            int fin = (finPaire < finPart) ? finPaire : finPart;
+            const int *A = source + debutPaire;
+            const int *B = source + milieu;
+            int nA = milieu - debutPaire;
+            int nB = finPaire - milieu;
+            int i0 = coRang(k - debutPaire, A, nA, B, nB);
+            int i1 = coRang(fin - debutPaire, A, nA, B, nB);
+            int j0 = k - debutPaire - i0;
+            int j1 = fin - debutPaire - i1;
+            fusionner(A + i0, i1 - i0, B + j0, j1 - j0, destination + k);
+            k = fin;
+        }
+        // toutes les parts doivent être écrites avant que la destination soit relue
+        if (nb > 1){
+            pthread_barrier_wait(&barriere);
+        }
+        int *temp = source;
+        source = destination;
+        destination = temp;
+    }
+
+    // nombre impair de passes : le résultat est dans le tampon
+    if (source != tableauTri){
+        int debut = (int)((long)n * id / nb);
+        int fin = (int)((long)n * (id + 1) / nb);
+        memcpy(tableauTri + debut, source + debut, (size_t)(fin - debut) * sizeof(int));
+    }
+}
+
+int coRang(int d, const int A[], int nA, const int B[], int nB){
+    /*
+    * nombre d'entiers de A parmi les d premiers de la fusion stable de A et B (à égalité,
+    * A passe d'abord) : recherche dichotomique du plus petit i tel que A[i] > B[d - i - 1]
+    */
+    int bas = (d - nB > 0) ? d - nB : 0;
+    int haut = (d < nA) ? d : nA;
+    while (bas < haut){
+        int i = bas + (haut - bas) / 2;
+        int j = d - i;
+        if (i < nA && j > 0 && A[i] <= B[j - 1]){
+            bas = i + 1;
+        } else {
+            haut = i;
+        }
+    }
+    return bas;
+}
+
+void trierBloc(int T[], int n){
+    // bloc complet : réseau de tri en registres ; fin du tableau : tri par insertion
+#ifdef AVEC_AVX2
+    if (avx2Disponible && n == TAILLE_BLOC){
+        trierBlocAvx2(T);
+        return;
+    }
+#endif
+    for (int i = 1 ; i < n ; i++){
+        int x = T[i];
+        int j = i - 1;
+        while (j >= 0 && T[j] > x){
+            T[j + 1] = T[j];
+            j--;
+        }
+        T[j + 1] = x;
+    }
+}
+
+void fusionner(const int A[], int nA, const int B[], int nB, int sortie[]){
+#ifdef AVEC_AVX2
+    if (avx2Disponible && nA >= 8 && nB >= 8){
+        fusionnerAvx2(A, nA, B, nB, sortie);
+        return;
+    }
+#endif
+    fusionnerScalaire(A, nA, B, nB, sortie);
+}
+
+void fusionnerScalaire(const int A[], int nA, const int B[], int nB, int sortie[]){
+    // fusion stable sans branchement dans la boucle : à égalité, l'entier de A passe d'abord
+    int i = 0, j = 0, k = 0;
+    while (i < nA && j < nB){
+        int prendreB = B[j] < A[i];
+        sortie[k++] = prendreB ? B[j] : A[i];
+        j += prendreB;
+        i += 1 - prendreB;
+    }
+    memcpy(sortie + k, A + i, (size_t)(nA - i) * sizeof(int));
+    memcpy(sortie + k + nA - i, B + j, (size_t)(nB - j) * sizeof(int));
+}
+
+void passesFusionStable(int id, int nb){
+    /*
+    * passesFusion sur des couples : blocs triés par insertion, puis fusions scalaires qui
+    * prennent dans la suite de gauche à égalité ; les co-rangs coupent la fusion au même
+    * endroit que cette fusion stable, donc l'ordre des égaux est gardé d'un bout à l'autre
+    */
+    int n = tailleTri;
+    tElement *source = elementsTri;
+    tElement *destination = tamponElements;
+    int nbBlocs = (n + TAILLE_BLOC - 1) / TAILLE_BLOC;
+
+    for (long b = (long)nbBlocs * id / nb ; b < (long)nbBlocs * (id + 1) / nb ; b++){
+        int debut = (int)b * TAILLE_BLOC;
+        trierBlocStable(source + debut, (n - debut < TAILLE_BLOC) ? n - debut : TAILLE_BLOC);
+    }
+    if (nb > 1){
+        pthread_barrier_wait(&barriere);
+    }
+
+    for (long largeur = TAILLE_BLOC ; largeur < n ; largeur *= 2){
+        int debutPart = (int)((long)n * id / nb);
+        int finPart = (int)((long)n * (id + 1) / nb);
+        int k = debutPart;
+        while (k < finPart){
+            int debutPaire = (int)(k / (2 * largeur) * (2 * largeur));
+            int milieu = (int)((debutPaire + largeur < n) ? debutPaire + largeur : n);
+            int finPaire = (int)((debutPaire + 2 * largeur < n) ? debutPaire + 2 * largeur : n);
+            int fin = (finPaire < finPart) ? finPaire : finPart;
+            const tElement *A = source + debutPaire;
+            const tElement *B = source + milieu;
+            int nA = milieu - debutPaire;
+            int nB = finPaire - milieu;
+            int i0 = coRangStable(k - debutPaire, A, nA, B, nB);
+            int i1 = coRangStable(fin - debutPaire, A, nA, B, nB);
+            int j0 = k - debutPaire - i0;
+            int j1 = fin - debutPaire - i1;
+            fusionnerStable(A + i0, i1 - i0, B + j0, j1 - j0, destination + k);
+            k = fin;
+        }
+        if (nb > 1){
+            pthread_barrier_wait(&barriere);
+        }
+        tElement *temp = source;
+        source = destination;
+        destination = temp;
+    }
+
+    if (source != elementsTri){
+        int debut = (int)((long)n * id / nb);
+        int fin = (int)((long)n * (id + 1) / nb);
+        memcpy(elementsTri + debut, source + debut, (size_t)(fin - debut) * sizeof(tElement));
+    }
+}
+
+int coRangStable(int d, const tElement A[], int nA, const tElement B[], int nB){
+    // coRang sur les clés : à égalité, l'élément de A passe d'abord
+    int bas = (d - nB > 0) ? d - nB : 0;
+    int haut = (d < nA) ? d : nA;
+    while (bas < haut){
+        int i = bas + (haut - bas) / 2;
+        int j = d - i;
+        if (i < nA && j > 0 && A[i].cle <= B[j - 1].cle){
+            bas = i + 1;
+        } else {
+            haut = i;
+        }
+    }
+    return bas;
+}
+
+void trierBlocStable(tElement T[], int n){
+    // tri par insertion : un élément ne dépasse jamais une clé égale
+    for (int i = 1 ; i < n ; i++){
+        tElement x = T[i];
+        int j = i - 1;
+        while (j >= 0 && T[j].cle > x.cle){
+            T[j + 1] = T[j];
+            j--;
+        }
+        T[j + 1] = x;
+    }
+}
+
+void fusionnerStable(const tElement A[], int nA, const tElement B[], int nB, tElement sortie[]){
+    // comme fusionnerScalaire : B n'est pris que si sa clé est strictement plus petite
+    int i = 0, j = 0, k = 0;
+    while (i < nA && j < nB){
+        int prendreB = B[j].cle < A[i].cle;
+        // choix d'une adresse plutôt que d'un couple : le compilateur garde un cmov
+        sortie[k++] = *(prendreB ? &B[j] : &A[i]);
+        j += prendreB;
+        i += 1 - prendreB;
+    }
+    memcpy(sortie + k, A + i, (size_t)(nA - i) * sizeof(tElement));
+    memcpy(sortie + k + nA - i, B + j, (size_t)(nB - j) * sizeof(tElement));
+}
+
+int verifieStabilite(const tElement T[], int n){
+    // après verifieTableau : les éléments de même clé doivent garder leur ordre d'origine
+    for (int i = 1 ; i < n ; i++){
+        if (T[i - 1].cle == T[i].cle && T[i - 1].charge > T[i].charge){
+            printf("tri non stable : la clé %d de la position %d passe avant celle de la position %d\n",
+                   T[i].cle, T[i - 1].charge, T[i].charge);
+            return 0;
+        }
+    }
+    printf("tri stable\n");
+    return 1;
+}
+
+#ifdef AVEC_AVX2
+__attribute__((target("avx2")))
+void nettoyer8(__m256i *v){
+    // une suite bitonique de 8 entiers devient croissante : comparaisons à distance 4, 2 puis 1
+    __m256i p = _mm256_permute2x128_si256(*v, *v, 1);
+    *v = COMPARER_ECHANGER(*v, p, 0xF0);
+    p = _mm256_shuffle_epi32(*v, _MM_SHUFFLE(1, 0, 3, 2));
+    *v = COMPARER_ECHANGER(*v, p, 0xCC);
+    p = _mm256_shuffle_epi32(*v, _MM_SHUFFLE(2, 3, 0, 1));
+    *v = COMPARER_ECHANGER(*v, p, 0xAA);
+}
+
+__attribute__((target("avx2")))
+void trier8(__m256i *v){
+    // tri bitonique de 8 entiers : paires alternées, puis quadruplets croissant et
+    // décroissant, puis une suite bitonique de 8
+    __m256i p = _mm256_shuffle_epi32(*v, _MM_SHUFFLE(2, 3, 0, 1));
+    *v = COMPARER_ECHANGER(*v, p, 0x66);
+    p = _mm256_shuffle_epi32(*v, _MM_SHUFFLE(1, 0, 3, 2));
+    *v = COMPARER_ECHANGER(*v, p, 0x3C);
+    p = _mm256_shuffle_epi32(*v, _MM_SHUFFLE(2, 3, 0, 1));
+    *v = COMPARER_ECHANGER(*v, p, 0x5A);
+    nettoyer8(v);
+}
+
+__attribute__((target("avx2")))
+void fusionner8(__m256i *bas, __m256i *haut){
+    // deux suites croissantes de 8 : bas reçoit les 8 plus petits, haut les 8 plus grands, triés
+    __m256i inverse = _mm256_permutevar8x32_epi32(*haut, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    __m256i a = _mm256_min_epi32(*bas, inverse);
+    __m256i b = _mm256_max_epi32(*bas, inverse);
+    nettoyer8(&a);
+    nettoyer8(&b);
+    *bas = a;
+    *haut = b;
+}
+
+__attribute__((target("avx2")))
+void trierBlocAvx2(int T[]){
+    // 16 entiers dans deux registres : chaque moitié est triée puis les deux sont fusionnées
+    __m256i a = _mm256_loadu_si256((__m256i *)T);
+    __m256i b = _mm256_loadu_si256((__m256i *)(T + 8));
+    trier8(&a);
+    trier8(&b);
+    fusionner8(&a, &b);
+    _mm256_storeu_si256((__m256i *)T, a);
+    _mm256_storeu_si256((__m256i *)(T + 8), b);
+}
+
+__attribute__((target("avx2")))
+void fusionnerAvx2(const int A[], int nA, const int B[], int nB, int sortie[]){
+    /*
+    * fusion 8 par 8 de deux suites d'au moins 8 entiers : haut garde les 8 plus grands
+    * entiers lus et pas encore écrits, et le bloc suivant est lu dans la suite dont le
+    * prochain entier est le plus petit. Quand cette suite a moins de 8 entiers, haut est
+    * fusionné avec sa fin, puis le tout avec le reste de l'autre suite, sans vecteurs
+    */
+    __m256i bas = _mm256_loadu_si256((const __m256i *)A);
+    __m256i haut = _mm256_loadu_si256((const __m256i *)B);
+    int garde[8], fin[16];
+    int i = 8, j = 8, k = 0;
+    int depuisA;
+    for (;;){
+        fusionner8(&bas, &haut);
+        _mm256_storeu_si256((__m256i *)(sortie + k), bas);
+        k += 8;
+        depuisA = (j == nB) || (i < nA && A[i] <= B[j]);
+        if (depuisA){
+            if (nA - i < 8){
+                break;
+            }
+            bas = _mm256_loadu_si256((const __m256i *)(A + i));
+            i += 8;
+        } else {
+            if (nB - j < 8){
+                break;
+            }
+            bas = _mm256_loadu_si256((const __m256i *)(B + j));
+            j += 8;
+        }
+    }
+    _mm256_storeu_si256((__m256i *)garde, haut);
+    if (depuisA){
+        fusionnerScalaire(garde, 8, A + i, nA - i, fin);
+        fusionnerScalaire(fin, 8 + nA - i, B + j, nB - j, sortie + k);
+    } else {
+        fusionnerScalaire(garde, 8, B + j, nB - j, fin);
+        fusionnerScalaire(fin, 8 + nB - j, A + i, nA - i, sortie + k);
+    }
+}
+#else
+void trierBlocAvx2(int T[]){
+    // sans AVX2 (autre processeur que x86), trierBloc n'appelle jamais cette fonction
+    (void)T;
+}
+
+void fusionnerAvx2(const int A[], int nA, const int B[], int nB, int sortie[]){
+    // sans AVX2, fusionner n'appelle jamais cette fonction
+    fusionnerScalaire(A, nA, B, nB, sortie);
+}
+#endif
+
+void trierBanc(int T[], int n){
+    trierFusion(T, n);
+}
+
@@ -1,29 +1,108 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#define TAILLE 300000
-typedef int tableau[TAILLE];
+// tri par insertion classique, ou en mode adaptatif (OPTION_ADAPTATIF) : nom de
+// l'algorithme dans les résultats du banc d'essai selon le mode
+int triAdaptatif = 0;
+#define NOM_ALGORITHME (triAdaptatif ? "tri_insertion_adaptatif" : "tri_insertion")
+#include "tableau.h"
 
-void tri_insertion(tableau T);
-void affichetableau(tableau T);
-int aleatoire();
-void genereTableau(tableau T);
+// mode adaptatif : jusqu'à SEUIL_FUSION éléments, le tableau est trié par insertion
+// dichotomique ; au-delà, les suites déjà triées sont repérées, allongées par insertion
+// jusqu'à LONGUEUR_MIN_SUITE éléments, puis fusionnées deux à deux
+#define OPTION_ADAPTATIF "--adaptatif"
+#define SEUIL_FUSION 64
+#define LONGUEUR_MIN_SUITE 32
+// taille maximale par défaut du banc d'essai du tri classique, en O(n²)
+#define TAILLE_MAX_BANC_CLASSIQUE 100000
 
-int main(){
-    time_t debut = time(NULL);
-    tableau T = {};
-    genereTableau(T);
-    tri_insertion(T);
-    affichetableau(T);
-    time_t fin = time(NULL);
-    printf("durée : %3.f secondes\n", difftime(fin, debut));
-    return EXIT_SUCCESS;
+void tri_insertion(tableau T, int n);
+void trier(int T[], int n);
+void insertionBinaire(int T[], int debut, int fin, int dejaTries);
+int positionInsertion(int T[], int debut, int fin, int x);
+int premierNonInferieur(int T[], int debut, int fin, int x);
+int premierSuperieur(int T[], int debut, int fin, int x);
+int longueurSuite(int T[], int debut, int n);
+void triFusionNaturel(int T[], int n);
+void fusionner(int T[], int debut, int milieu, int fin, int tampon[]);
+
+int main(int argc, char *argv[]){
+    int banc = 0;
+    int tailleMaxDonnee = 0;
+    int n = TAILLE;
+    const char *entree = NULL;
+    int *T;
+    for (int i = 1 ; i < argc ; i++){
+        if (strcmp(argv[i], OPTION_BINAIRE) == 0){
+            modeSortie = SORTIE_BINAIRE;
+        } else if (strcmp(argv[i], OPTION_VERIFIER) == 0){
+            modeSortie = SORTIE_VERIFICATION;
+        } else if (strcmp(argv[i], OPTION_SEPARATEUR) == 0 && i + 1 < argc && argv[i + 1][0] != '\0'){
+            separateur = argv[++i][0];
+        } else if (strcmp(argv[i], OPTION_BANC) == 0){
+            banc = 1;
+        } else if (strcmp(argv[i], OPTION_TAILLE_MAX) == 0 && i + 1 < argc){
+            tailleMaxBanc = atol(argv[++i]);
+            tailleMaxDonnee = 1;
+        } else if (strcmp(argv[i], OPTION_ADAPTATIF) == 0){
+            triAdaptatif = 1;
+        } else if (strcmp(argv[i], OPTION_TAILLE) == 0 && i + 1 < argc){
+            n = atoi(argv[++i]);
+        } else if (strcmp(argv[i], OPTION_ENTREE) == 0 && i + 1 < argc){
+            entree = argv[++i];
+        }
+    }
+    if (n < 0){
+        n = 0;
+    }
+    if (banc){
+        if (!triAdaptatif && !tailleMaxDonnee){
+            tailleMaxBanc = TAILLE_MAX_BANC_CLASSIQUE;
+        }
+        bancEssai();
+        return EXIT_SUCCESS;
+    }
+    if (entree != NULL){
+        T = projeterFichier(entree, &n);
+    } else {
+        T = allouerTableau((size_t)n);
+        initGenerateur(&generateur, GRAINE, 0);
+        genereTableau(T, n);
+    }
+    double debutTri = chronometre(CLOCK_MONOTONIC);
+    trier(T, n);
+    double dureeTri = chronometre(CLOCK_MONOTONIC) - debutTri;
+    int resultat = EXIT_SUCCESS;
+    if (modeSortie == SORTIE_VERIFICATION){
+        if (!verifieTableau(T, n)){
+            resultat = EXIT_FAILURE;
+        }
+    } else {
+        afficheTableau(T, n);
+    }
+    // sur la sortie d'erreur, pour ne pas se mêler au tableau
+    fprintf(stderr, "durée du tri : %.3f ms\n", dureeTri / 1e6);
+    if (entree != NULL){
+        libererProjection(T, n);
+    } else {
+        libererTableau(T, (size_t)n);
+    }
+    return resultat;
 }
 
-void tri_insertion(tableau T){
+void tri_insertion(tableau T, int n){
+    // tri par insertion classique : chaque élément est décalé d'une case à la fois
     int x, j = 0;
-    for (int i = 1 ; i <= (TAILLE - 1) ; i++){
+    for (int i = 1 ; i <= (n - 1) ; i++){
         x = T[i];
         j = i;
         while ((j > 0) && (T[j - 1] > x )){
@@ -34,20 +113,159 @@ void tri_insertion(tableau T){
     }
 }
 
-void affichetableau(tableau T){
-    for (int i = 0 ; i < TAILLE ; i++){
-        printf("%d", T[i]);
+void trier(int T[], int n){
+    if (!triAdaptatif){
+        tri_insertion(T, n);
+    } else if (n <= SEUIL_FUSION){
+        insertionBinaire(T, 0, n, 1);
+    } else {
+        triFusionNaturel(T, n);
+    }
+}
+
+void insertionBinaire(int T[], int debut, int fin, int dejaTries){
+    // tri par insertion de T[debut..fin[ dont les dejaTries premiers sont déjà triés :
+    // la place de chaque élément est cherchée par galop puis dichotomie, et les
+    // éléments plus grands sont décalés d'un bloc avec memmove
+    int x, j;
+    for (int i = debut + dejaTries ; i < fin ; i++){
+        x = T[i];
+        if (T[i - 1] <= x){
+            continue;
+        }
+        j = positionInsertion(T, debut, i, x);
+        memmove(&T[j + 1], &T[j], (size_t)(i - j) * sizeof(int));
+        T[j] = x;
+    }
+}
+
+int positionInsertion(int T[], int debut, int fin, int x){
+    // premier indice de T[debut..fin[ (trié) dont la valeur est plus grande que x.
+    // Galop depuis la fin (pas de 1, 2, 4...) : pour une entrée presque triée, la place
+    // est près de la fin et se trouve en quelques comparaisons
+    int haut = fin, pas = 1;
+    while (haut - pas >= debut && T[haut - pas] > x){
+        haut -= pas;
+        pas *= 2;
+    }
+    int bas = (haut - pas >= debut) ? haut - pas + 1 : debut;
+    return premierSuperieur(T, bas, haut, x);
+}
+
+int premierSuperieur(int T[], int debut, int fin, int x){
+    // dichotomie : premier indice de T[debut..fin[ (trié) tel que T[i] > x, fin si aucun
+    while (debut < fin){
+        int milieu = debut + (fin - debut) / 2;
+        if (T[milieu] > x){
+            fin = milieu;
+        } else {
+            debut = milieu + 1;
+        }
+    }
+    return debut;
+}
+
+int premierNonInferieur(int T[], int debut, int fin, int x){
+    // dichotomie : premier indice de T[debut..fin[ (trié) tel que T[i] >= x, fin si aucun
+    while (debut < fin){
+        int milieu = debut + (fin - debut) / 2;
+        if (T[milieu] >= x){
+            fin = milieu;
+        } else {
+            debut = milieu + 1;
+        }
     }
+    return debut;
 }
 
-int aleatoire(){
-    srand(time(NULL));
-    int x = rand();
-    return x;
+int longueurSuite(int T[], int debut, int n){
+    // longueur de la suite triée qui commence en debut : croissante au sens large, ou
+    // strictement décroissante (retournée sur place, ce qui garde le tri stable)
+    int fin = debut + 1;
+    if (fin == n){
+        return 1;
+    }
+    if (T[fin] < T[debut]){
+        while (fin + 1 < n && T[fin + 1] < T[fin]){
+            fin++;
+        }
+        for (int i = debut, j = fin ; i < j ; i++, j--){
+            int temp = T[i];
+            T[i] = T[j];
+            T[j] = temp;
+        }
+    } else {
+        while (fin + 1 < n && T[fin + 1] >= T[fin]){
+            fin++;
+        }
+    }
+    return fin - debut + 1;
 }
 
-void genereTableau(tableau T){
-    for (int i = 0; i < TAILLE ; i++){
-        T[i] = aleatoire();
+void triFusionNaturel(int T[], int n){
+    // découpe en suites triées (au moins LONGUEUR_MIN_SUITE éléments), puis fusion des
+    // suites voisines deux à deux jusqu'à n'en avoir plus qu'une : O(n log n) au pire,
+    // O(n) sur une entrée déjà triée
+    int *debuts = malloc(((size_t)n / LONGUEUR_MIN_SUITE + 2) * sizeof(int));
+    int *tampon = allouerTableau((size_t)n);
+    if (debuts == NULL){
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    int nbSuites = 0;
+    int debut = 0;
+    while (debut < n){
+        int longueur = longueurSuite(T, debut, n);
+        if (longueur < LONGUEUR_MIN_SUITE){
+            int fin = (debut + LONGUEUR_MIN_SUITE < n) ? debut + LONGUEUR_MIN_SUITE : n;
+            insertionBinaire(T, debut, fin, longueur);
+            longueur = fin - debut;
+        }
+        debuts[nbSuites++] = debut;
+        debut += longueur;
     }
-}
\ No newline at end of file
+    debuts[nbSuites] = n;
+
+    while (nbSuites > 1){
+        int k = 0;
+        for (int i = 0 ; i < nbSuites ; i += 2){
+            if (i + 1 < nbSuites){
+                fusionner(T, debuts[i], debuts[i + 1], debuts[i + 2], tampon);
+            }
+            debuts[k++] = debuts[i];
+        }
+        debuts[k] = n;
+        nbSuites = k;
+    }
+    free(debuts);
+    libererTableau(tampon, (size_t)n);
+}
+
+void fusionner(int T[], int debut, int milieu, int fin, int tampon[]){
+    // fusion stable de T[debut..milieu[ et T[milieu..fin[, déjà triés
+    if (T[milieu - 1] <= T[milieu]){
+        return;
+    }
+    // les éléments de gauche plus petits que le premier de droite et ceux de droite
+    // pas plus petits que le dernier de gauche sont déjà à leur place
+    debut = premierSuperieur(T, debut, milieu, T[milieu]);
+    fin = premierNonInferieur(T, milieu, fin, T[milieu - 1]);
+
+    int nbGauche = milieu - debut;
+    memcpy(tampon, &T[debut], (size_t)nbGauche * sizeof(int));
+    int i = 0, j = milieu, k = debut;
+    while (i < nbGauche && j < fin){
+        if (T[j] < tampon[i]){
+            T[k++] = T[j++];
+        } else {
+            T[k++] = tampon[i++];
+        }
+    }
+    // le reste de droite est déjà en place
+    memcpy(&T[k], &tampon[i], (size_t)(nbGauche - i) * sizeof(int));
+}
+
+void trierBanc(int T[], int n){
+    trier(T, n);
+}
+
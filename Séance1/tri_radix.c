@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+// nom de l'algorithme dans les résultats du banc d'essai
+#define NOM_ALGORITHME "tri_radix"
+#include "tableau.h"
+
+// tri par base (radix LSD) : 3 passes sur des chiffres de 11 bits couvrent les 32 bits d'un int
+#define BITS_CHIFFRE 11
+#define NB_SEAUX (1 << BITS_CHIFFRE)
+#define MASQUE_CHIFFRE (NB_SEAUX - 1)
+#define NB_PASSES 3
+// le bit de signe est inversé pour que l'ordre des clés non signées soit celui des int
+#define BIT_SIGNE 0x80000000u
+// au-dessus de SEUIL_PARALLELE éléments, histogrammes et répartition sont partagés entre threads
+#define SEUIL_PARALLELE 1000000
+#define NB_THREADS_MAX 64
+
+// un thread du tri parallèle : sa tranche du tableau, l'histogramme de sa tranche
+// pour la passe en cours et la position où il écrit chaque seau
+typedef struct {
+    pthread_t thread;
+    int id;
+    int debut;
+    int fin;
+    int histogramme[NB_SEAUX];
+    int positions[NB_SEAUX];
+} tTravailleur;
+
+// état du tri parallèle en cours, partagé par les threads
+tTravailleur travailleurs[NB_THREADS_MAX];
+pthread_barrier_t barriere;
+unsigned int *tableauTri;
+unsigned int *tamponTri;
+int tailleTri;
+int passeInutile;
+int nbThreads = 1;
+
+void triRadix(tableau T, int n);
+void trierRadix(int T[], int n);
+void trierRadixParallele(int T[], int n);
+void *travailleurRadix(void *arg);
+void calculerPositions();
+int chiffre(unsigned int x, int passe);
+
+int main(int argc, char *argv[]){
+    int banc = 0;
+    int n = TAILLE;
+    const char *entree = NULL;
+    int *T;
+    for (int i = 1 ; i < argc ; i++){
+        if (strcmp(argv[i], OPTION_BINAIRE) == 0){
+            modeSortie = SORTIE_BINAIRE;
+        } else if (strcmp(argv[i], OPTION_VERIFIER) == 0){
+            modeSortie = SORTIE_VERIFICATION;
+        } else if (strcmp(argv[i], OPTION_SEPARATEUR) == 0 && i + 1 < argc && argv[i + 1][0] != '\0'){
+            separateur = argv[++i][0];
+        } else if (strcmp(argv[i], OPTION_BANC) == 0){
+            banc = 1;
+        } else if (strcmp(argv[i], OPTION_TAILLE_MAX) == 0 && i + 1 < argc){
+            tailleMaxBanc = atol(argv[++i]);
+        } else if (strcmp(argv[i], OPTION_TAILLE) == 0 && i + 1 < argc){
+            n = atoi(argv[++i]);
+        } else if (strcmp(argv[i], OPTION_ENTREE) == 0 && i + 1 < argc){
+            entree = argv[++i];
+        }
+    }
+    if (n < 0){
+        n = 0;
+    }
+    nbThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nbThreads < 1){
+        nbThreads = 1;
+    } else if (nbThreads > NB_THREADS_MAX){
+        nbThreads = NB_THREADS_MAX;
+    }
+    if (banc){
+        bancEssai();
+        return EXIT_SUCCESS;
+    }
+    if (entree != NULL){
+        T = projeterFichier(entree, &n);
+    } else {
+        T = allouerTableau((size_t)n);
+        initGenerateur(&generateur, GRAINE, 0);
+        genereTableau(T, n);
+    }
+    double debutTri = chronometre(CLOCK_MONOTONIC);
+    triRadix(T, n);
+    double dureeTri = chronometre(CLOCK_MONOTONIC) - debutTri;
+    int resultat = EXIT_SUCCESS;
+    if (modeSortie == SORTIE_VERIFICATION){
+        if (!verifieTableau(T, n)){
+            resultat = EXIT_FAILURE;
+        }
+    } else {
+        afficheTableau(T, n);
+    }
+    // sur la sortie d'erreur, pour ne pas se mêler au tableau
+    fprintf(stderr, "durée du tri : %.3f ms\n", dureeTri / 1e6);
+    if (entree != NULL){
+        libererProjection(T, n);
+    } else {
+        libererTableau(T, (size_t)n);
+    }
+    return resultat;
+}
+
+void triRadix(tableau T, int n){
+    trierRadix(T, n);
+}
+
+int chiffre(unsigned int x, int passe){
+    return (int)(((x ^ BIT_SIGNE) >> (passe * BITS_CHIFFRE)) & MASQUE_CHIFFRE);
+}
+
+void trierRadix(int T[], int n){
+    /*
+    * tri par base, chiffre de poids faible d'abord : les histogrammes des 3 chiffres sont
+    * calculés en une seule lecture du tableau, puis chaque passe répartit les éléments dans
+    * le tampon selon un chiffre et les deux tableaux échangent leur rôle. Une passe dont tous
+    * les éléments ont le même chiffre est sautée
+    */
+    if (n < 2){
+        return;
+    }
+    if (nbThreads > 1 && n >= SEUIL_PARALLELE){
+        trierRadixParallele(T, n);
+        return;
+    }
+    int (*histogrammes)[NB_SEAUX] = calloc(NB_PASSES, sizeof(*histogrammes));
+    unsigned int *tampon = (unsigned int *)allouerTableau((size_t)n);
+    if (histogrammes == NULL){
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    unsigned int *source = (unsigned int *)T;
+    unsigned int *destination = tampon;
+
+    for (int i = 0 ; i < n ; i++){
+        unsigned int cle = source[i] ^ BIT_SIGNE;
+        histogrammes[0][cle & MASQUE_CHIFFRE]++;
+        histogrammes[1][(cle >> BITS_CHIFFRE) & MASQUE_CHIFFRE]++;
+        histogrammes[2][cle >> (2 * BITS_CHIFFRE)]++;
+    }
+
+    for (int passe = 0 ; passe < NB_PASSES ; passe++){
+        int *histogramme = histogrammes[passe];
+        if (histogramme[chiffre(source[0], passe)] == n){
+            continue;
+        }
+        // position de départ de chaque seau dans la destination
+        int position = 0;
+        for (int b = 0 ; b < NB_SEAUX ; b++){
+            int nombre = histogramme[b];
+            histogramme[b] = position;
+            position += nombre;
+        }
+        for (int i = 0 ; i < n ; i++){
+            destination[histogramme[chiffre(source[i], passe)]++] = source[i];
+        }
+        unsigned int *temp = source;
+        source = destination;
+        destination = temp;
+    }
+
+    if (source != (unsigned int *)T){
+        memcpy(T, source, (size_t)n * sizeof(int));
+    }
+    free(histogrammes);
+    libererTableau((int *)tampon, (size_t)n);
+}
+
+void trierRadixParallele(int T[], int n){
+    // chaque thread a sa tranche du tableau ; le thread principal est le travailleur 0
+    tableauTri = (unsigned int *)T;
+    tamponTri = (unsigned int *)allouerTableau((size_t)n);
+    tailleTri = n;
+    pthread_barrier_init(&barriere, NULL, (unsigned int)nbThreads);
+    for (int i = 0 ; i < nbThreads ; i++){
+        travailleurs[i].id = i;
+        travailleurs[i].debut = (int)((long)n * i / nbThreads);
+        travailleurs[i].fin = (int)((long)n * (i + 1) / nbThreads);
+    }
+    for (int i = 1 ; i < nbThreads ; i++){
+        if (pthread_create(&travailleurs[i].thread, NULL, travailleurRadix, &travailleurs[i]) != 0){
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    travailleurRadix(&travailleurs[0]);
+    for (int i = 1 ; i < nbThreads ; i++){
+        pthread_join(travailleurs[i].thread, NULL);
+    }
+    pthread_barrier_destroy(&barriere);
+    libererTableau((int *)tamponTri, (size_t)n);
+}
+
+void *travailleurRadix(void *arg){
+    /*
+    * pour chaque passe : histogramme de la tranche du thread, positions de chaque seau
+    * pour chaque thread (seau par seau, puis thread par thread : le tri reste stable),
+    * puis répartition de la tranche dans la destination. Les barrières séparent les étapes
+    */
+    tTravailleur *travailleur = arg;
+    unsigned int *source = tableauTri;
+    unsigned int *destination = tamponTri;
+
+    for (int passe = 0 ; passe < NB_PASSES ; passe++){
+        memset(travailleur->histogramme, 0, sizeof(travailleur->histogramme));
+        for (int i = travailleur->debut ; i < travailleur->fin ; i++){
+            travailleur->histogramme[chiffre(source[i], passe)]++;
+        }
+        pthread_barrier_wait(&barriere);
+        if (travailleur->id == 0){
+            calculerPositions();
+        }
+        pthread_barrier_wait(&barriere);
+        if (passeInutile){
+            continue;
+        }
+        for (int i = travailleur->debut ; i < travailleur->fin ; i++){
+            destination[travailleur->positions[chiffre(source[i], passe)]++] = source[i];
+        }
+        // toutes les répartitions doivent être finies avant la passe suivante
+        pthread_barrier_wait(&barriere);
+        unsigned int *temp = source;
+        source = destination;
+        destination = temp;
+    }
+
+    // nombre impair de passes effectuées : le résultat est dans le tampon
+    if (source != tableauTri){
+        memcpy(tableauTri + travailleur->debut, source + travailleur->debut,
+               (size_t)(travailleur->fin - travailleur->debut) * sizeof(unsigned int));
+    }
+    return NULL;
+}
+
+void calculerPositions(){
+    // appelée par un seul thread entre deux barrières
+    int position = 0;
+    passeInutile = 0;
+    for (int b = 0 ; b < NB_SEAUX ; b++){
+        int total = 0;
+        for (int i = 0 ; i < nbThreads ; i++){
+            travailleurs[i].positions[b] = position + total;
+            total += travailleurs[i].histogramme[b];
+        }
+        if (total == tailleTri){
+            passeInutile = 1;
+        }
+        position += total;
+    }
+}
+
+void trierBanc(int T[], int n){
+    trierRadix(T, n);
+}
+
@@ -1,72 +1,879 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AVEC_AVX2
+#endif
 
-#define TAILLE 300000
-typedef int tableau[TAILLE];
+// nom de l'algorithme dans les résultats du banc d'essai
+#define NOM_ALGORITHME "tri_rapide"
+#include "tableau.h"
+
+// en dessous de SEUIL_INSERTION éléments, une partie est finie par un tri par insertion
+#define SEUIL_INSERTION 16
+// au-dessus de SEUIL_PARALLELE éléments, une partie peut être confiée à un autre thread
+#define SEUIL_PARALLELE 65536
+#define NB_THREADS_MAX 64
+// nombre maximal de tâches en attente dans la pile d'un thread : un thread ne dépose
+// qu'une tâche par partition de sa branche, donc au plus la profondeur maximale
+#define CAPACITE_PILE 256
+// à partir de SEUIL_VECTORIEL éléments, la partition compare 8 entiers à la fois (AVX2)
+#define SEUIL_VECTORIEL 64
+
+// une partie du tableau à trier et la profondeur de partitions qui lui reste
+// avant de passer au tri par tas
+typedef struct {
+    int debut;
+    int fin;
+    int profondeur;
+} tTache;
+
+// pile de tâches d'un thread : le thread dépose et reprend ses tâches en haut,
+// les autres threads volent les plus anciennes (les plus grandes) en bas
+typedef struct {
+    pthread_mutex_t verrou;
+    tTache taches[CAPACITE_PILE];
+    int bas;
+    int haut;
+} tPile;
+
+// état du tri parallèle en cours
+int *tableauPartage;
+tPile piles[NB_THREADS_MAX];
+int nbThreads = 1;
+atomic_long tachesEnCours;
+
+// partition vectorielle : le processeur a-t-il AVX2 (vérifié à l'exécution), et pour chaque
+// masque des entiers plus grands que le pivot, l'ordre des 8 entiers qui place les plus
+// petits au début et les plus grands à la fin
+int avx2Disponible = 0;
+int permutations[256][8];
+
+// tri externe (OPTION_EXTERNE) du fichier binaire OPTION_ENTREE vers OPTION_SORTIE, pour les
+// fichiers plus grands que la mémoire : suites triées en mémoire puis fusionnées, sans jamais
+// utiliser plus de OPTION_MEMOIRE Mio de tampons
+#define OPTION_EXTERNE "--externe"
+#define OPTION_SORTIE "--sortie"
+#define OPTION_MEMOIRE "--memoire"
+#define MEMOIRE_DEFAUT_MO 1024
+// taille minimale du tampon de lecture de chaque suite pendant une fusion
+#define TAILLE_TAMPON_FUSION_MIN (1UL << 20)
+
+// une suite triée dans un fichier temporaire : position en octets et nombre d'entiers
+typedef struct {
+    off_t debut;
+    long nombre;
+} tSuite;
+
+// lecture d'une suite du fichier d'entrée par un thread, pendant le tri de la précédente
+typedef struct {
+    int fd;
+    int *tampon;
+    long capacite;
+    long nombre;
+} tLectureSuite;
+
+// lecture tamponnée d'une suite pendant une fusion
+typedef struct {
+    int *tampon;
+    long capacite;
+    long position;
+    long dansTampon;
+    off_t prochaineLecture;
+    long restants;
+} tLecteur;
 
 int partition(tableau t, int debut, int fin, int pivot);
+void partitionner(int t[], int debut, int fin, int pivot, int *finGauche, int *debutDroite);
+void initPartitionVectorielle();
+int partitionAvx2(int t[], int debut, int fin, int valeur, int strict);
 void triRapide(tableau t, int debut, int fin);
-int aleatoire();
-void genereTableau(tableau T);
-void afficheTableau(tableau T);
+void introTri(int t[], int debut, int fin, int profondeur);
+int choisirPivot(int t[], int debut, int fin);
+int medianeDeTrois(int t[], int a, int b, int c);
+void triInsertion(int t[], int debut, int fin);
+void triTas(int t[], int debut, int fin);
+void tamiser(int t[], int debut, int racine, int taille);
+void echanger(int t[], int i, int j);
+int profondeurMax(int taille);
+void triParallele(int id, int debut, int fin, int profondeur);
+void *travailleur(void *arg);
+void deposerTache(int id, int debut, int fin, int profondeur);
+int prendreTache(int id, tTache *tache);
+int volerTache(int id, tTache *tache);
+void triExterne(const char *entree, const char *sortie, size_t memoire);
+void *lecteurSuite(void *arg);
+int fichierTemporaire();
+int ouvrirSortie(const char *sortie, char nom[], size_t tailleNom);
+long tailleTampon(size_t octets);
+long fusionnerSuites(int fdEntree, tSuite suites[], int k, int fdSortie, size_t memoire);
+void remplirLecteur(int fd, tLecteur *lecteur);
+int plusPetit(tLecteur lecteurs[], int a, int b);
+void rejouer(tLecteur lecteurs[], int perdants[], int k, int feuille);
 
-int main(){
-    time_t debut  = time(NULL);
-    tableau t = {};
-    genereTableau(t);
-    triRapide(t, 5, 1);
-    afficheTableau(t);
-    time_t fin = time(NULL);
-    printf("durée : %3.f secondes\n", difftime(fin, debut));
-    return EXIT_SUCCESS;
+int main(int argc, char *argv[]){
+    int banc = 0;
+    int n = TAILLE;
+    int externe = 0;
+    const char *entree = NULL;
+    const char *sortie = NULL;
+    long memoireMo = MEMOIRE_DEFAUT_MO;
+    int *t;
+    for (int i = 1 ; i < argc ; i++){
+        if (strcmp(argv[i], OPTION_BINAIRE) == 0){
+            modeSortie = SORTIE_BINAIRE;
+        } else if (strcmp(argv[i], OPTION_VERIFIER) == 0){
+            modeSortie = SORTIE_VERIFICATION;
+        } else if (strcmp(argv[i], OPTION_SEPARATEUR) == 0 && i + 1 < argc && argv[i + 1][0] != '\0'){
+            separateur = argv[++i][0];
+        } else if (strcmp(argv[i], OPTION_BANC) == 0){
+            banc = 1;
+        } else if (strcmp(argv[i], OPTION_TAILLE_MAX) == 0 && i + 1 < argc){
+            tailleMaxBanc = atol(argv[++i]);
+        } else if (strcmp(argv[i], OPTION_TAILLE) == 0 && i + 1 < argc){
+            n = atoi(argv[++i]);
+        } else if (strcmp(argv[i], OPTION_ENTREE) == 0 && i + 1 < argc){
+            entree = argv[++i];
+        } else if (strcmp(argv[i], OPTION_EXTERNE) == 0){
+            externe = 1;
+        } else if (strcmp(argv[i], OPTION_SORTIE) == 0 && i + 1 < argc){
+            sortie = argv[++i];
+        } else if (strcmp(argv[i], OPTION_MEMOIRE) == 0 && i + 1 < argc){
+            memoireMo = atol(argv[++i]);
+        }
+    }
+    if (n < 0){
+        n = 0;
+    }
+    nbThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (nbThreads < 1){
+        nbThreads = 1;
+    } else if (nbThreads > NB_THREADS_MAX){
+        nbThreads = NB_THREADS_MAX;
+    }
+    if (banc){
+        bancEssai();
+        return EXIT_SUCCESS;
+    }
+    if (externe){
+        if (entree == NULL || sortie == NULL || memoireMo < 1){
+            fprintf(stderr, "%s demande %s <fichier>, %s <fichier> et %s <Mio> positif\n",
+                    OPTION_EXTERNE, OPTION_ENTREE, OPTION_SORTIE, OPTION_MEMOIRE);
+            return EXIT_FAILURE;
+        }
+        double debutTri = chronometre(CLOCK_MONOTONIC);
+        triExterne(entree, sortie, (size_t)memoireMo << 20);
+        fprintf(stderr, "durée du tri externe : %.3f ms\n", (chronometre(CLOCK_MONOTONIC) - debutTri) / 1e6);
+        return EXIT_SUCCESS;
+    }
+    if (entree != NULL){
+        t = projeterFichier(entree, &n);
+    } else {
+        t = allouerTableau((size_t)n);
+        initGenerateur(&generateur, GRAINE, 0);
+        genereTableau(t, n);
+    }
+    double debutTri = chronometre(CLOCK_MONOTONIC);
+    triRapide(t, 0, n - 1);
+    double dureeTri = chronometre(CLOCK_MONOTONIC) - debutTri;
+    int resultat = EXIT_SUCCESS;
+    if (modeSortie == SORTIE_VERIFICATION){
+        if (!verifieTableau(t, n)){
+            resultat = EXIT_FAILURE;
+        }
+    } else {
+        afficheTableau(t, n);
+    }
+    // sur la sortie d'erreur, pour ne pas se mêler au tableau
+    fprintf(stderr, "durée du tri : %.3f ms\n", dureeTri / 1e6);
+    if (entree != NULL){
+        libererProjection(t, n);
+    } else {
+        libererTableau(t, (size_t)n);
+    }
+    return resultat;
 }
 
 int partition(tableau t, int debut, int fin, int pivot){
-    int temp = 0, temp2 = 0, temp3 = 0;
-    t[pivot] = temp;
-    t[pivot] = t[fin];
-    t[fin] = temp;
-    int j = debut;
-    for (int i = debut ; i < (fin -1) ; i++){
-        if (t[i] <= t[fin]){
-            t[i] = temp2;
-            t[i] = t[fin];
-            t[fin] = temp2;
-            j++;
+    // partition de Hoare : le pivot est placé en fin, les deux indices s'arrêtent
+    // sur les valeurs égales au pivot pour couper en deux les suites de doublons
+    echanger(t, pivot, fin);
+    int valeur = t[fin];
+    int i = debut - 1;
+    int j = fin;
+    for (;;){
+        while (t[++i] < valeur){
         }
+        while (j > debut && t[--j] > valeur){
+        }
+        if (i >= j){
+            break;
+        }
+        echanger(t, i, j);
     }
-    t[fin] = temp3;
-    t[fin] = t[j];
-    t[j] = temp3;
+    echanger(t, i, fin);
 
-    return j;
+    return i;
+}
+
+void partitionner(int t[], int debut, int fin, int pivot, int *finGauche, int *debutDroite){
+    // partition autour de t[pivot] : t[debut..finGauche] <= pivot <= t[debutDroite..fin].
+    // Avec AVX2, les valeurs égales au pivot peuvent rester entre les deux parties
+#ifdef AVEC_AVX2
+    if (avx2Disponible && fin - debut + 1 >= SEUIL_VECTORIEL){
+        echanger(t, pivot, fin);
+        int valeur = t[fin];
+        int milieu = partitionAvx2(t, debut, fin - 1, valeur, 0);
+        echanger(t, milieu, fin);
+        *finGauche = milieu - 1;
+        *debutDroite = milieu + 1;
+        // partie gauche 7 fois plus grande que la droite : sans doute beaucoup de valeurs
+        // égales au pivot, qui sont regroupées contre lui et n'ont plus à être triées
+        if (milieu - debut >= 7 * (fin - milieu) && milieu - debut >= SEUIL_VECTORIEL){
+            *finGauche = partitionAvx2(t, debut, milieu - 1, valeur, 1) - 1;
+        }
+        return;
+    }
+#endif
+    int milieu = partition(t, debut, fin, pivot);
+    *finGauche = milieu - 1;
+    *debutDroite = milieu + 1;
 }
 
+void initPartitionVectorielle(){
+    // pour le masque m, les indices des bits à 0 (entiers qui vont à gauche) puis ceux
+    // des bits à 1 (entiers qui vont à droite), chacun dans l'ordre
+    int k;
+#ifdef AVEC_AVX2
+    avx2Disponible = __builtin_cpu_supports("avx2");
+#endif
+    for (int m = 0 ; m < 256 ; m++){
+        k = 0;
+        for (int i = 0 ; i < 8 ; i++){
+            if (!(m & (1 << i))){
+                permutations[m][k++] = i;
+            }
+        }
+        for (int i = 0 ; i < 8 ; i++){
+            if (m & (1 << i)){
+                permutations[m][k++] = i;
+            }
+        }
+    }
+}
+
+#ifdef AVEC_AVX2
+__attribute__((target("avx2")))
+int partitionAvx2(int t[], int debut, int fin, int valeur, int strict){
+    /*
+    * partition sans branchement de t[debut..fin] (au moins 16 entiers) : à gauche les
+    * entiers <= valeur (< valeur si strict), à droite les autres. Retourne l'indice du
+    * premier entier de droite. Les 8 premiers et les 8 derniers entiers sont mis de
+    * côté : il reste toujours 16 places libres, réparties entre la gauche et la droite.
+    * Chaque bloc de 8 entiers est lu du côté qui a le moins de place, réordonné par la
+    * table des permutations puis écrit en entier des deux côtés : les entiers de gauche
+    * au début de la place libre à gauche, ceux de droite à la fin de la place libre à droite
+    */
+    if (strict && valeur == (int)0x80000000){
+        return debut;
+    }
+    __m256i seuil = _mm256_set1_epi32(strict ? valeur - 1 : valeur);
+    __m256i gauche = _mm256_loadu_si256((__m256i *)(t + debut));
+    __m256i droite = _mm256_loadu_si256((__m256i *)(t + fin + 1 - 8));
+    // entiers non lus : [lectureG, lectureD[ ; places libres : [ecritureG, lectureG[ et [lectureD, ecritureD[
+    int lectureG = debut + 8, lectureD = fin + 1 - 8;
+    int ecritureG = debut, ecritureD = fin + 1;
+    int reste[24];
+    int nbReste = 0;
+
+    while (lectureD - lectureG >= 8){
+        __m256i bloc;
+        if (lectureG - ecritureG <= ecritureD - lectureD){
+            bloc = _mm256_loadu_si256((__m256i *)(t + lectureG));
+            lectureG += 8;
+        } else {
+            lectureD -= 8;
+            bloc = _mm256_loadu_si256((__m256i *)(t + lectureD));
+        }
+        int masque = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(bloc, seuil)));
+        int nbDroite = __builtin_popcount(masque);
+        bloc = _mm256_permutevar8x32_epi32(bloc, _mm256_loadu_si256((__m256i *)permutations[masque]));
+        _mm256_storeu_si256((__m256i *)(t + ecritureG), bloc);
+        _mm256_storeu_si256((__m256i *)(t + ecritureD - 8), bloc);
+        ecritureG += 8 - nbDroite;
+        ecritureD -= nbDroite;
+    }
+
+    // moins de 8 entiers non lus et les 16 mis de côté remplissent exactement la place libre
+    for (int i = lectureG ; i < lectureD ; i++){
+        reste[nbReste++] = t[i];
+    }
+    _mm256_storeu_si256((__m256i *)(reste + nbReste), gauche);
+    _mm256_storeu_si256((__m256i *)(reste + nbReste + 8), droite);
+    nbReste += 16;
+    for (int i = 0 ; i < nbReste ; i++){
+        if (strict ? reste[i] < valeur : reste[i] <= valeur){
+            t[ecritureG++] = reste[i];
+        } else {
+            t[--ecritureD] = reste[i];
+        }
+    }
+    return ecritureG;
+}
+#else
+int partitionAvx2(int t[], int debut, int fin, int valeur, int strict){
+    // sans AVX2 (autre processeur que x86), partitionner n'appelle jamais cette fonction
+    (void)t; (void)debut; (void)fin; (void)valeur; (void)strict;
+    return debut;
+}
+#endif
+
 void triRapide(tableau t, int debut, int fin){
-    int pivot;
-    if (debut < fin) {
-        pivot = (debut+fin)/2;
-        pivot = partition(t, debut, fin, pivot);
-        triRapide(t, debut, pivot-1);
-        triRapide(t, pivot+1, fin);
+    if (debut >= fin){
+        return;
+    }
+    int profondeur = profondeurMax(fin - debut + 1);
+    initPartitionVectorielle();
+    if (nbThreads <= 1 || fin - debut + 1 <= SEUIL_PARALLELE){
+        introTri(t, debut, fin, profondeur);
+        return;
+    }
+
+    // tri parallèle : le thread principal est le travailleur 0 et commence avec tout le tableau
+    pthread_t threads[NB_THREADS_MAX];
+    int ids[NB_THREADS_MAX];
+    tableauPartage = t;
+    for (int i = 0 ; i < nbThreads ; i++){
+        pthread_mutex_init(&piles[i].verrou, NULL);
+        piles[i].bas = 0;
+        piles[i].haut = 0;
+        ids[i] = i;
+    }
+    atomic_store(&tachesEnCours, 0);
+    deposerTache(0, debut, fin, profondeur);
+    for (int i = 1 ; i < nbThreads ; i++){
+        if (pthread_create(&threads[i], NULL, travailleur, &ids[i]) != 0){
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    travailleur(&ids[0]);
+    for (int i = 1 ; i < nbThreads ; i++){
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0 ; i < nbThreads ; i++){
+        pthread_mutex_destroy(&piles[i].verrou);
+    }
+}
+
+void introTri(int t[], int debut, int fin, int profondeur){
+    // tri rapide qui passe au tri par tas quand les pivots sont trop mauvais
+    // et finit les petites parties par insertion
+    while (fin - debut + 1 > SEUIL_INSERTION){
+        if (profondeur == 0){
+            triTas(t, debut, fin);
+            return;
+        }
+        profondeur--;
+        int finGauche, debutDroite;
+        partitionner(t, debut, fin, choisirPivot(t, debut, fin), &finGauche, &debutDroite);
+        // appel récursif sur la plus petite partie : la pile d'appels reste en O(log n)
+        if (finGauche - debut < fin - debutDroite){
+            introTri(t, debut, finGauche, profondeur);
+            debut = debutDroite;
+        } else {
+            introTri(t, debutDroite, fin, profondeur);
+            fin = finGauche;
+        }
+    }
+    triInsertion(t, debut, fin);
+}
+
+int choisirPivot(int t[], int debut, int fin){
+    // médiane de trois pour les petites parties, médiane de trois médianes de trois (neuf
+    // valeurs réparties sur toute la partie) pour les grandes : la partition vectorielle
+    // mélange les entiers d'une entrée déjà triée et trois valeurs n'y suffisent plus
+    int milieu = debut + (fin - debut) / 2;
+    if (fin - debut + 1 < SEUIL_VECTORIEL){
+        return medianeDeTrois(t, debut, milieu, fin);
+    }
+    int ecart = (fin - debut) / 8;
+    return medianeDeTrois(t, medianeDeTrois(t, debut, debut + ecart, debut + 2 * ecart),
+                             medianeDeTrois(t, milieu - ecart, milieu, milieu + ecart),
+                             medianeDeTrois(t, fin - 2 * ecart, fin - ecart, fin));
+}
+
+int medianeDeTrois(int t[], int a, int b, int c){
+    // indice de la valeur médiane parmi t[a], t[b] et t[c]
+    if (t[a] < t[b]){
+        if (t[b] < t[c]){
+            return b;
+        }
+        return (t[a] < t[c]) ? c : a;
+    }
+    if (t[a] < t[c]){
+        return a;
+    }
+    return (t[b] < t[c]) ? c : b;
+}
+
+void triInsertion(int t[], int debut, int fin){
+    int x, j;
+    for (int i = debut + 1 ; i <= fin ; i++){
+        x = t[i];
+        j = i;
+        while ((j > debut) && (t[j - 1] > x)){
+            t[j] = t[j - 1];
+            j--;
+        }
+        t[j] = x;
+    }
+}
+
+void triTas(int t[], int debut, int fin){
+    int taille = fin - debut + 1;
+    for (int i = taille / 2 - 1 ; i >= 0 ; i--){
+        tamiser(t, debut, i, taille);
+    }
+    for (int i = taille - 1 ; i > 0 ; i--){
+        echanger(t, debut, debut + i);
+        tamiser(t, debut, 0, i);
+    }
+}
+
+void tamiser(int t[], int debut, int racine, int taille){
+    // fait descendre t[debut + racine] dans le tas de taille éléments commençant en debut
+    int x = t[debut + racine];
+    int enfant = 2 * racine + 1;
+    while (enfant < taille){
+        if (enfant + 1 < taille && t[debut + enfant + 1] > t[debut + enfant]){
+            enfant++;
+        }
+        if (t[debut + enfant] <= x){
+            break;
+        }
+        t[debut + racine] = t[debut + enfant];
+        racine = enfant;
+        enfant = 2 * racine + 1;
+    }
+    t[debut + racine] = x;
+}
+
+void echanger(int t[], int i, int j){
+    int temp = t[i];
+    t[i] = t[j];
+    t[j] = temp;
+}
+
+int profondeurMax(int taille){
+    // 2 * log2(taille) partitions avant de passer au tri par tas
+    int profondeur = 0;
+    while (taille > 1){
+        taille /= 2;
+        profondeur += 2;
+    }
+    return profondeur;
+}
+
+void triParallele(int id, int debut, int fin, int profondeur){
+    // tant que la partie est grande, la plus petite moitié de chaque partition
+    // est déposée pour les autres threads et le thread continue sur la plus grande
+    int *t = tableauPartage;
+    while (fin - debut + 1 > SEUIL_PARALLELE && profondeur > 0){
+        profondeur--;
+        int finGauche, debutDroite;
+        partitionner(t, debut, fin, choisirPivot(t, debut, fin), &finGauche, &debutDroite);
+        if (finGauche - debut < fin - debutDroite){
+            deposerTache(id, debut, finGauche, profondeur);
+            debut = debutDroite;
+        } else {
+            deposerTache(id, debutDroite, fin, profondeur);
+            fin = finGauche;
+        }
+    }
+    introTri(t, debut, fin, profondeur);
+}
+
+void *travailleur(void *arg){
+    // chaque thread traite ses propres tâches, puis vole celles des autres,
+    // jusqu'à ce qu'il ne reste plus aucune tâche en cours
+    int id = *(int *)arg;
+    tTache tache;
+    while (atomic_load(&tachesEnCours) > 0){
+        if (prendreTache(id, &tache) || volerTache(id, &tache)){
+            triParallele(id, tache.debut, tache.fin, tache.profondeur);
+            atomic_fetch_sub(&tachesEnCours, 1);
+        } else {
+            sched_yield();
+        }
     }
+    return NULL;
 }
 
-int aleatoire(){
-    srand(time(NULL));
-    int x = rand();
-    return x;
+void deposerTache(int id, int debut, int fin, int profondeur){
+    tPile *pile = &piles[id];
+    // la tâche est comptée avant d'être visible : le compteur ne tombe à 0
+    // qu'une fois toutes les parties triées
+    atomic_fetch_add(&tachesEnCours, 1);
+    pthread_mutex_lock(&pile->verrou);
+    if (pile->haut == CAPACITE_PILE){
+        pthread_mutex_unlock(&pile->verrou);
+        // pile pleine (ne devrait pas arriver) : la tâche est triée tout de suite
+        introTri(tableauPartage, debut, fin, profondeur);
+        atomic_fetch_sub(&tachesEnCours, 1);
+        return;
+    }
+    pile->taches[pile->haut].debut = debut;
+    pile->taches[pile->haut].fin = fin;
+    pile->taches[pile->haut].profondeur = profondeur;
+    pile->haut++;
+    pthread_mutex_unlock(&pile->verrou);
+}
+
+int prendreTache(int id, tTache *tache){
+    // reprend la dernière tâche déposée par le thread
+    tPile *pile = &piles[id];
+    int trouve = 0;
+    pthread_mutex_lock(&pile->verrou);
+    if (pile->haut > pile->bas){
+        pile->haut--;
+        *tache = pile->taches[pile->haut];
+        trouve = 1;
+    }
+    if (pile->haut == pile->bas){
+        pile->bas = 0;
+        pile->haut = 0;
+    }
+    pthread_mutex_unlock(&pile->verrou);
+    return trouve;
 }
 
-void genereTableau(tableau T){
-    for (int i = 0; i < TAILLE ; i++){
-        T[i] = aleatoire();
+int volerTache(int id, tTache *tache){
+    // vole la plus ancienne tâche du premier autre thread qui en a
+    for (int k = 1 ; k < nbThreads ; k++){
+        tPile *pile = &piles[(id + k) % nbThreads];
+        int trouve = 0;
+        pthread_mutex_lock(&pile->verrou);
+        if (pile->haut > pile->bas){
+            *tache = pile->taches[pile->bas];
+            pile->bas++;
+            trouve = 1;
+        }
+        if (pile->haut == pile->bas){
+            pile->bas = 0;
+            pile->haut = 0;
+        }
+        pthread_mutex_unlock(&pile->verrou);
+        if (trouve){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void triExterne(const char *entree, const char *sortie, size_t memoire){
+    /*
+    * 1) le fichier est découpé en suites qui tiennent dans la moitié de la mémoire permise :
+    *    chaque suite est triée (en parallèle par triRapide) pendant qu'un thread lit la
+    *    suivante dans l'autre moitié, puis écrite à la suite des autres dans un fichier
+    *    temporaire
+    * 2) les suites sont fusionnées par groupes d'au plus fusionMax (arbre des perdants) tant
+    *    qu'il en reste trop pour que chacune ait un tampon de lecture d'au moins
+    *    TAILLE_TAMPON_FUSION_MIN octets, la dernière fusion écrivant dans un fichier temporaire
+    *    à côté du fichier de sortie, qui le remplace une fois complet : la sortie n'est
+    *    jamais tronquée par une erreur, et peut être le fichier d'entrée
+    */
+    int fdEntree = open(entree, O_RDONLY);
+    if (fdEntree < 0){
+        perror(entree);
+        exit(EXIT_FAILURE);
+    }
+    posix_fadvise(fdEntree, 0, 0, POSIX_FADV_SEQUENTIAL);
+    long longueurSuite = tailleTampon(memoire / 2);
+    if (longueurSuite > INT_MAX){
+        longueurSuite = INT_MAX;
+    }
+    if (longueurSuite < 1){
+        longueurSuite = 1;
+    }
+    int fusionMax = (int)(memoire / TAILLE_TAMPON_FUSION_MIN) - 1;
+    if (fusionMax < 2){
+        fusionMax = 2;
+    }
+
+    int capaciteSuites = 16;
+    int nbSuites = 0;
+    tSuite *suites = malloc((size_t)capaciteSuites * sizeof(tSuite));
+    int *tampons[2] = {allouerTableau((size_t)longueurSuite), allouerTableau((size_t)longueurSuite)};
+    int fdTemporaire = fichierTemporaire();
+    off_t position = 0;
+    int courant = 0;
+    tLectureSuite lecture = {fdEntree, tampons[0], longueurSuite, 0};
+    lecteurSuite(&lecture);
+    while (lecture.nombre > 0){
+        long nombre = lecture.nombre;
+        pthread_t lecteur;
+        lecture.tampon = tampons[1 - courant];
+        if (pthread_create(&lecteur, NULL, lecteurSuite, &lecture) != 0){
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+        triRapide(tampons[courant], 0, (int)nombre - 1);
+        ecrireTout(fdTemporaire, (const char *)tampons[courant], (size_t)nombre * sizeof(int));
+        if (nbSuites == capaciteSuites){
+            capaciteSuites *= 2;
+            suites = realloc(suites, (size_t)capaciteSuites * sizeof(tSuite));
+        }
+        suites[nbSuites].debut = position;
+        suites[nbSuites].nombre = nombre;
+        nbSuites++;
+        position += (off_t)nombre * (off_t)sizeof(int);
+        pthread_join(lecteur, NULL);
+        courant = 1 - courant;
+    }
+    libererTableau(tampons[0], (size_t)longueurSuite);
+    libererTableau(tampons[1], (size_t)longueurSuite);
+    close(fdEntree);
+
+    while (nbSuites > fusionMax){
+        int fdPasse = fichierTemporaire();
+        int nbFusionnees = 0;
+        position = 0;
+        for (int g = 0 ; g < nbSuites ; g += fusionMax){
+            int k = (nbSuites - g < fusionMax) ? nbSuites - g : fusionMax;
+            long nombre = fusionnerSuites(fdTemporaire, &suites[g], k, fdPasse, memoire);
+            // le groupe fusionné remplace ses suites, qui ont déjà été lues
+            suites[nbFusionnees].debut = position;
+            suites[nbFusionnees].nombre = nombre;
+            nbFusionnees++;
+            position += (off_t)nombre * (off_t)sizeof(int);
+        }
+        close(fdTemporaire);
+        fdTemporaire = fdPasse;
+        nbSuites = nbFusionnees;
+    }
+    char nomSortie[4096];
+    int fdSortie = ouvrirSortie(sortie, nomSortie, sizeof(nomSortie));
+    fusionnerSuites(fdTemporaire, suites, nbSuites, fdSortie, memoire);
+    close(fdTemporaire);
+    free(suites);
+    if (close(fdSortie) < 0 || rename(nomSortie, sortie) < 0){
+        perror(sortie);
+        unlink(nomSortie);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void *lecteurSuite(void *arg){
+    // lit la suite suivante du fichier d'entrée : au plus capacite entiers
+    tLectureSuite *lecture = arg;
+    size_t taille = (size_t)lecture->capacite * sizeof(int);
+    size_t lu = 0;
+    while (lu < taille){
+        ssize_t n = read(lecture->fd, (char *)lecture->tampon + lu, taille - lu);
+        if (n < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            perror("read");
+            exit(EXIT_FAILURE);
+        }
+        if (n == 0){
+            break;
+        }
+        lu += (size_t)n;
+    }
+    if (lu % sizeof(int) != 0){
+        fprintf(stderr, "fichier d'entrée : taille incorrecte pour un tableau d'int\n");
+        exit(EXIT_FAILURE);
     }
+    lecture->nombre = (long)(lu / sizeof(int));
+    return NULL;
 }
 
-void afficheTableau(tableau T){
-    for (int i = 0 ; i < TAILLE ; i++){
-        printf("%d", T[i]);
+int fichierTemporaire(){
+    // fichier effacé dès sa création : il disparaît à sa fermeture ou à la fin du programme
+    const char *dossier = getenv("TMPDIR");
+    char nom[4096];
+    snprintf(nom, sizeof(nom), "%s/tri_externe_XXXXXX", (dossier != NULL) ? dossier : "/tmp");
+    int fd = mkstemp(nom);
+    if (fd < 0){
+        perror(nom);
+        exit(EXIT_FAILURE);
     }
-}
\ No newline at end of file
+    unlink(nom);
+    return fd;
+}
+
+int ouvrirSortie(const char *sortie, char nom[], size_t tailleNom){
+    /*
+    * fichier temporaire dans le dossier de sortie (rename ne change pas de système de
+    * fichiers), avec les droits qu'aurait eus la sortie créée par open(..., 0644)
+    */
+    snprintf(nom, tailleNom, "%s.XXXXXX", sortie);
+    int fd = mkstemp(nom);
+    if (fd < 0){
+        perror(nom);
+        exit(EXIT_FAILURE);
+    }
+    mode_t masque = umask(0);
+    umask(masque);
+    fchmod(fd, 0644 & ~masque);
+    return fd;
+}
+
+long tailleTampon(size_t octets){
+    /*
+    * nombre d'entiers d'un tampon d'au plus octets octets. allouerTableau arrondit au-dessus
+    * tout tableau d'au moins une grande page : la taille est donc arrondie au-dessous à un
+    * nombre entier de grandes pages, pour que la somme des tampons reste dans la mémoire permise
+    */
+    if (octets >= TAILLE_GRANDE_PAGE){
+        octets -= octets % TAILLE_GRANDE_PAGE;
+    }
+    return (long)(octets / sizeof(int));
+}
+
+long fusionnerSuites(int fdEntree, tSuite suites[], int k, int fdSortie, size_t memoire){
+    /*
+    * fusion de k suites triées de fdEntree, écrites à la suite dans fdSortie. La mémoire
+    * est partagée entre un tampon de lecture par suite et le tampon d'écriture. L'arbre des
+    * perdants garde dans chaque noeud la suite qui y a perdu ; perdants[0] est la suite dont
+    * l'entier courant est le plus petit, et seul le chemin de sa feuille à la racine est
+    * rejoué quand elle avance : log2(k) comparaisons par entier
+    */
+    long capacite = tailleTampon(memoire / ((size_t)k + 1));
+    if (capacite < 1024){
+        capacite = 1024;
+    }
+    tLecteur *lecteurs = malloc((size_t)k * sizeof(tLecteur));
+    int *perdants = malloc(((size_t)k + 1) * sizeof(int));
+    int *tamponSortie = allouerTableau((size_t)capacite);
+    if (lecteurs == NULL || perdants == NULL){
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0 ; i < k ; i++){
+        lecteurs[i].tampon = allouerTableau((size_t)capacite);
+        lecteurs[i].capacite = capacite;
+        lecteurs[i].position = 0;
+        lecteurs[i].dansTampon = 0;
+        lecteurs[i].prochaineLecture = suites[i].debut;
+        lecteurs[i].restants = suites[i].nombre;
+        remplirLecteur(fdEntree, &lecteurs[i]);
+    }
+    for (int i = 0 ; i <= k ; i++){
+        perdants[i] = -1;
+    }
+    for (int i = k - 1 ; i >= 0 ; i--){
+        rejouer(lecteurs, perdants, k, i);
+    }
+
+    long total = 0;
+    long dansSortie = 0;
+    while (k > 0){
+        int i = perdants[0];
+        tLecteur *lecteur = &lecteurs[i];
+        if (lecteur->position == lecteur->dansTampon){
+            // la suite gagnante est épuisée : toutes le sont
+            break;
+        }
+        tamponSortie[dansSortie++] = lecteur->tampon[lecteur->position++];
+        if (dansSortie == capacite){
+            ecrireTout(fdSortie, (const char *)tamponSortie, (size_t)dansSortie * sizeof(int));
+            total += dansSortie;
+            dansSortie = 0;
+        }
+        if (lecteur->position == lecteur->dansTampon){
+            remplirLecteur(fdEntree, lecteur);
+        }
+        rejouer(lecteurs, perdants, k, i);
+    }
+    ecrireTout(fdSortie, (const char *)tamponSortie, (size_t)dansSortie * sizeof(int));
+    total += dansSortie;
+
+    for (int i = 0 ; i < k ; i++){
+        libererTableau(lecteurs[i].tampon, (size_t)capacite);
+    }
+    libererTableau(tamponSortie, (size_t)capacite);
+    free(lecteurs);
+    free(perdants);
+    return total;
+}
+
+void remplirLecteur(int fd, tLecteur *lecteur){
+    // recharge le tampon d'une suite ; un tampon vide après l'appel signifie suite épuisée
+    long nombre = (lecteur->restants < lecteur->capacite) ? lecteur->restants : lecteur->capacite;
+    size_t taille = (size_t)nombre * sizeof(int);
+    size_t lu = 0;
+    while (lu < taille){
+        ssize_t n = pread(fd, (char *)lecteur->tampon + lu, taille - lu, lecteur->prochaineLecture + (off_t)lu);
+        if (n < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            perror("pread");
+            exit(EXIT_FAILURE);
+        }
+        if (n == 0){
+            fprintf(stderr, "fichier temporaire tronqué\n");
+            exit(EXIT_FAILURE);
+        }
+        lu += (size_t)n;
+    }
+    lecteur->prochaineLecture += (off_t)taille;
+    lecteur->restants -= nombre;
+    lecteur->position = 0;
+    lecteur->dansTampon = nombre;
+}
+
+int plusPetit(tLecteur lecteurs[], int a, int b){
+    // une suite épuisée est plus grande que toutes les autres ; à égalité, la suite
+    // d'indice le plus petit passe d'abord
+    tLecteur *x = &lecteurs[a];
+    tLecteur *y = &lecteurs[b];
+    if (y->position == y->dansTampon){
+        return x->position < x->dansTampon || a < b;
+    }
+    if (x->position == x->dansTampon){
+        return 0;
+    }
+    int u = x->tampon[x->position];
+    int v = y->tampon[y->position];
+    return u < v || (u == v && a < b);
+}
+
+void rejouer(tLecteur lecteurs[], int perdants[], int k, int feuille){
+    // remonte de la feuille à la racine : à chaque noeud, le gagnant continue et le perdant
+    // reste. À la construction, un noeud vide (-1) garde le premier arrivé
+    int gagnant = feuille;
+    for (int noeud = (feuille + k) / 2 ; noeud > 0 ; noeud /= 2){
+        if (perdants[noeud] == -1){
+            perdants[noeud] = gagnant;
+            return;
+        }
+        if (plusPetit(lecteurs, perdants[noeud], gagnant)){
+            int perdant = gagnant;
+            gagnant = perdants[noeud];
+            perdants[noeud] = perdant;
+        }
+    }
+    perdants[0] = gagnant;
+}
+
+void trierBanc(int T[], int n){
+    triRapide(T, 0, n - 1);
+}
+
@@ -22,8 +22,13 @@
 #include <stdbool.h>
 #include <unistd.h>
 #include <termios.h>
-#include <fcntl.h>
 #include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 
 // taille du serpent
@@ -51,8 +56,6 @@
 #define BORDURE '#'
 #define VIDE ' '
 #define POMME '6'
-// nombre servant a la convertion du temps en seconde
-#define CONVERTION_SECONDE 1000
 
 
 // définition d'un type pour le plateau : tPlateau
@@ -67,6 +70,30 @@ typedef char tPlateau[LARGEUR_PLATEAU+1][HAUTEUR_PLATEAU+1];
 int nbPommes = 0;
 int nbDepUnitaires = 0;
 
+// lecture du clavier : le terminal passe une seule fois en mode brut pour toute la partie,
+// un thread attend les touches (au plus ATTENTE_CLAVIER millisecondes à la fois, pour voir
+// la demande d'arrêt) et les dépose dans une file circulaire de TAILLE_FILE_TOUCHES touches
+// (puissance de 2) que la boucle de jeu vide sans appel système
+#define ATTENTE_CLAVIER 100
+#define TAILLE_FILE_TOUCHES 64
+
+// file des touches sans verrou : seul le thread du clavier avance queue,
+// seule la boucle de jeu avance tete
+typedef struct
+{
+	char touches[TAILLE_FILE_TOUCHES];
+	atomic_uint tete;
+	atomic_uint queue;
+} tFileTouches;
+
+tFileTouches fileTouches;
+pthread_t threadClavier;
+atomic_bool arretClavier;
+bool clavierDemarre = false;
+// réglages du terminal avant le mode brut, remis à la sortie ou sur un signal d'arrêt
+struct termios terminalInitial;
+volatile sig_atomic_t terminalModifie = 0;
+
 /* Déclaration des fonctions et procédures (les prototypes) */
 void initPlateau(tPlateau plateau);
 void dessinerPlateau(tPlateau plateau);
@@ -76,9 +103,13 @@ void effacer(int x, int y);
 void dessinerSerpent(int lesX[], int lesY[]);
 void progresser(int lesX[], int lesY[], char direction, tPlateau plateau, bool * collision, bool * pomme);
 void gotoxy(int x, int y);
-int kbhit();
-void disable_echo();
-void enable_echo();
+void demarrerClavier();
+void arreterClavier();
+void restaurerTerminal();
+void signalArret(int numero);
+void *lireClavier(void *arg);
+void deposerTouche(char touche);
+bool lireTouche(char *touche);
 
 
 int main()
@@ -89,7 +120,7 @@ int main()
 	int lesY[TAILLE];
 
 	// représente la touche frappée par l'utilisateur : touche de direction ou pour l'arrêt
-	char touche;
+	char touche = '\0';
 
 	//direction courante du serpent (HAUT, BAS, GAUCHE ou DROITE)
 	char direction;
@@ -120,9 +151,9 @@ int main()
 
 	// initialisation : le serpent se dirige vers la DROITE
 	dessinerSerpent(lesX, lesY);
-	disable_echo();
+	demarrerClavier();
 	direction = DROITE;
-	time_t debut = clock();
+	clock_t debut = clock();
 
 	// boucle de jeu. Arret si touche STOP, si collision avec une bordure ou
 	// si toutes les pommes sont mangées
@@ -160,23 +191,19 @@ int main()
 			if (!collision)
 			{
 				usleep(ATTENTE);
-				if (kbhit()==1)
-				{
-					touche = getchar();
-				}
+				lireTouche(&touche);
 			}
 		}
 	} while ( (touche != STOP) && !collision && !gagne);
-    enable_echo();
+    arreterClavier();
 	gotoxy(HAUTEUR_PLATEAU+1, 1);
 	if (gagne)
 	{
 		clock_t fin = clock();
-		enable_echo();
 		gotoxy(LARGEUR_PLATEAU + 2, 1);
 		printf("Le serpent s'est déplacé de %d cases.\n", nbDepUnitaires);
 		gotoxy(LARGEUR_PLATEAU + 2, 2);
-		printf("La partie a durée %.2f secondes.\n", (difftime(fin, debut) / CONVERTION_SECONDE) );
+		printf("La partie a durée %.2f secondes.\n", (double)(fin - debut) / CLOCKS_PER_SEC);
 		gotoxy(1, HAUTEUR_PLATEAU+1);
 
 	}
@@ -319,80 +346,136 @@ void gotoxy(int x, int y)
     printf("\033[%d;%df", y, x);
 }
 
-int kbhit()
+void demarrerClavier()
 {
-	// la fonction retourne :
-	// 1 si un caractere est present
-	// 0 si pas de caractere présent
-	int unCaractere = 0;
-	struct termios oldt, newt;
-	int ch;
-	int oldf;
-
-	// mettre le terminal en mode non bloquant
-	tcgetattr(STDIN_FILENO, &oldt);
-	newt = oldt;
-	newt.c_lflag &= ~(ICANON | ECHO);
-	tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-	oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
-	fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
- 
-	ch = getchar();
-
-	// restaurer le mode du terminal
-	tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-	fcntl(STDIN_FILENO, F_SETFL, oldf);
- 
-	if(ch != EOF)
+	// terminal sans écho ni attente de fin de ligne, réglé une seule fois, puis lancement
+	// du thread de lecture. Le terminal est remis en état à la sortie du programme et
+	// sur les signaux d'arrêt
+	struct termios brut;
+	struct sigaction action;
+
+	if (tcgetattr(STDIN_FILENO, &terminalInitial) == -1)
+	{
+		perror("tcgetattr");
+		exit(EXIT_FAILURE);
+	}
+	brut = terminalInitial;
+	brut.c_lflag &= ~(ICANON | ECHO);
+	brut.c_cc[VMIN] = 1;
+	brut.c_cc[VTIME] = 0;
+	if (tcsetattr(STDIN_FILENO, TCSANOW, &brut) == -1)
+	{
+		perror("tcsetattr");
+		exit(EXIT_FAILURE);
+	}
+	terminalModifie = 1;
+	atexit(restaurerTerminal);
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = signalArret;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGHUP, &action, NULL);
+	sigaction(SIGQUIT, &action, NULL);
+
+	atomic_store(&arretClavier, false);
+	if (pthread_create(&threadClavier, NULL, lireClavier, NULL) != 0)
 	{
-		ungetc(ch, stdin);
-		unCaractere = 1;
-	} 
-	return unCaractere;
+		perror("pthread_create");
+		exit(EXIT_FAILURE);
+	}
+	clavierDemarre = true;
 }
 
-// Fonction pour désactiver l'echo
-void disable_echo()
+void arreterClavier()
 {
-    struct termios tty;
+	// le thread voit la demande d'arrêt au plus tard ATTENTE_CLAVIER millisecondes après
+	if (clavierDemarre)
+	{
+		atomic_store(&arretClavier, true);
+		pthread_join(threadClavier, NULL);
+		clavierDemarre = false;
+	}
+	restaurerTerminal();
+}
 
-    // Obtenir les attributs du terminal
-    if (tcgetattr(STDIN_FILENO, &tty) == -1) 
+void restaurerTerminal()
+{
+	if (terminalModifie)
 	{
-        perror("tcgetattr");
-        exit(EXIT_FAILURE);
-    }
+		tcsetattr(STDIN_FILENO, TCSANOW, &terminalInitial);
+		terminalModifie = 0;
+	}
+}
 
-    // Désactiver le flag ECHO
-    tty.c_lflag &= ~ECHO;
+void signalArret(int numero)
+{
+	// tcsetattr peut être appelée dans un gestionnaire de signal ; le signal est ensuite
+	// renvoyé avec son traitement par défaut, le programme s'arrête donc comme avant
+	struct sigaction action;
+
+	restaurerTerminal();
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = SIG_DFL;
+	sigemptyset(&action.sa_mask);
+	sigaction(numero, &action, NULL);
+	raise(numero);
+}
+
+void *lireClavier(void *arg)
+{
+	// producteur de la file : attend une touche avec poll, la lit et la dépose
+	struct pollfd entree;
+	char touche;
+	int pret;
 
-    // Appliquer les nouvelles configurations
-    if (tcsetattr(STDIN_FILENO, TCSANOW, &tty) == -1)
+	(void)arg;
+	entree.fd = STDIN_FILENO;
+	entree.events = POLLIN;
+	while (!atomic_load(&arretClavier))
 	{
-        perror("tcsetattr");
-        exit(EXIT_FAILURE);
-    }
+		pret = poll(&entree, 1, ATTENTE_CLAVIER);
+		if (pret < 0 && errno != EINTR)
+		{
+			break;
+		}
+		if (pret > 0)
+		{
+			// 0 octet lu : fin de l'entrée standard, plus aucune touche n'arrivera
+			if (read(STDIN_FILENO, &touche, 1) != 1)
+			{
+				break;
+			}
+			deposerTouche(touche);
+		}
+	}
+	return NULL;
 }
 
-// Fonction pour réactiver l'echo
-void enable_echo()
+void deposerTouche(char touche)
 {
-    struct termios tty;
+	// file pleine (la boucle de jeu ne lit qu'une touche par tour) : la touche est perdue
+	unsigned int queue = atomic_load_explicit(&fileTouches.queue, memory_order_relaxed);
+	unsigned int tete = atomic_load_explicit(&fileTouches.tete, memory_order_acquire);
 
-    // Obtenir les attributs du terminal
-    if (tcgetattr(STDIN_FILENO, &tty) == -1)
+	if (queue - tete < TAILLE_FILE_TOUCHES)
 	{
-        perror("tcgetattr");
-        exit(EXIT_FAILURE);
-    }
+		fileTouches.touches[queue % TAILLE_FILE_TOUCHES] = touche;
+		atomic_store_explicit(&fileTouches.queue, queue + 1, memory_order_release);
+	}
+}
 
-    // Réactiver le flag ECHO
-    tty.c_lflag |= ECHO;
+bool lireTouche(char *touche)
+{
+	// consommateur de la file : retourne false, sans changer touche, si aucune touche n'attend
+	unsigned int tete = atomic_load_explicit(&fileTouches.tete, memory_order_relaxed);
+	unsigned int queue = atomic_load_explicit(&fileTouches.queue, memory_order_acquire);
 
-    // Appliquer les nouvelles configurations
-    if (tcsetattr(STDIN_FILENO, TCSANOW, &tty) == -1)
+	if (tete == queue)
 	{
-        perror("tcsetattr");
-        exit(EXIT_FAILURE);
-    }
+		return false;
+	}
+	*touche = fileTouches.touches[tete % TAILLE_FILE_TOUCHES];
+	atomic_store_explicit(&fileTouches.tete, tete + 1, memory_order_release);
+	return true;
 }
\ No newline at end of file
@@ -17,6 +17,32 @@
  * Le serpent qui gagne est le serpent qui a mangé le plus de pommes avant l'autre.
  * Le jeu s'arrête quand 10 pommes sont mangées soit par le serpent 1 soit par le serpent 2
  * En cas de victoire, le nombre de déplacements réalisé par chacun des serpents est affiché.
+ * Lancé avec l'option --sans-affichage, le jeu se déroule sans dessin, sans attente
+ * et sans lecture du clavier, puis affiche uniquement les déplacements, les pommes
+ * mangées par chaque serpent et le temps CPU de la partie.
+ * Lancé avec l'option --tournoi N, le programme joue N parties sans affichage
+ * (pommes, pavés et positions de départ tirés au hasard à partir de --graine G)
+ * réparties sur --threads T threads, puis affiche les taux de victoire,
+ * les déplacements moyens et les causes de collision de chaque serpent.
+ * L'option --serpents N (1 à 64) fait jouer N serpents à la fois : tous se déplacent
+ * en même temps, un serpent en collision est éliminé et la partie continue tant qu'il
+ * reste au moins deux serpents en jeu. L'option --strategies donne la stratégie de
+ * chaque serpent, une lettre par serpent reprise en boucle (c : plus court chemin,
+ * v : gloutonne verticale d'abord, h : gloutonne horizontale d'abord, p : prévoyante, qui
+ * essaie toutes ses suites de déplacements sur quelques tours et les annule ensuite).
+ * L'option --frequence F fixe le nombre de tours par seconde d'une partie affichée
+ * (5 par défaut, 0 pour jouer sans attente) : les tours commencent à intervalles fixes,
+ * quel que soit le temps de calcul et d'affichage, et les tours en retard sont comptés.
+ * Avec l'option --profil, la durée de chaque phase des tours (choix des directions,
+ * collisions, déplacement, affichage, attente) est mesurée, et le nombre de tours, la durée
+ * moyenne, médiane, le 99e centile et le maximum de chaque phase sont écrits sur la sortie
+ * d'erreur en fin de partie, ou en cours de partie à la réception du signal SIGUSR1.
+ * Une partie seule lancée avec --graine G est mise en place au hasard comme une partie de
+ * tournoi. L'option --enregistrer F enregistre la partie dans le fichier F (mise en place,
+ * puis un octet par serpent et par tour), que --rejouer F rejoue à l'identique, à la vitesse
+ * de --frequence ; la touche r recule de 50 tours. --tour N commence le rejeu au tour N
+ * (sans affichage, le rejeu s'arrête au tour N et affiche les compteurs de ce tour).
+ * Une partie s'arrête après 20000 tours, ou après --tours-max N tours (0 : sans limite).
  *
  */
 
@@ -26,16 +52,33 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
 #include <unistd.h>
 #include <termios.h>
-#include <fcntl.h>
 #include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 /*
 * Définition de toutes les constantes nécéssaires au bon fonctionnement du code
 */
 // taille du serpent
 #define TAILLE 10
+// capacité du tampon circulaire des anneaux d'un serpent (puissance de 2,
+// taille maximale que peut atteindre un serpent qui grandit)
+#define TAILLE_MAX 4096
+#define MASQUE_ANNEAUX (TAILLE_MAX - 1)
+// nombre de mots de 64 bits d'une ligne d'un plan de bits : la case (x, y)
+// correspond au bit x % 64 du mot x / 64 de la ligne y
+#define MOTS_PAR_LIGNE ((LARGEUR_PLATEAU + 1 + 63) / 64)
+// nombre d'anneaux gagnés par un serpent à chaque pomme mangée (0 : le serpent ne grandit pas)
+#define CROISSANCE 0
 // dimensions du plateau
 #define LARGEUR_PLATEAU 80	
 #define HAUTEUR_PLATEAU 40
@@ -50,32 +93,109 @@
 #define X_INITIAL 40
 #define Y_INITIAL_SERPENT_1 13
 #define Y_INITIAL_SERPENT_2 27
-// caractères pour représenter les serpents (corps identiques mais têtes différentes)
+// caractère pour représenter le corps des serpents (identique pour tous, seules
+// les têtes diffèrent, voir TETES_SERPENTS)
 #define CORPS 'X'
-#define TETE_SERPENT_1 '1'
-#define TETE_SERPENT_2 '2'
+// nombre maximal de serpents d'une partie
+#define NB_SERPENTS_MAX 64
 // consantes permettant d'expliciter les directions
 #define HAUT 1
 #define BAS 2
 #define GAUCHE 3
 #define DROITE 4
 #define CHEMIN_POMME 5
+// nombre de cases du plateau (taille de la file du parcours en largeur)
+#define NB_CASES (LARGEUR_PLATEAU * HAUTEUR_PLATEAU)
 // coordonnées X et Y de chaque issue
-#define ISSUE_HAUT_X 40
+#define ISSUE_HAUT_X (LARGEUR_PLATEAU / 2)
 #define ISSUE_HAUT_Y 0
-#define ISSUE_BAS_X 40
-#define ISSUE_BAS_Y 40
+#define ISSUE_BAS_X (LARGEUR_PLATEAU / 2)
+#define ISSUE_BAS_Y HAUTEUR_PLATEAU
 #define ISSUE_GAUCHE_X 0
-#define ISSUE_GAUCHE_Y 20
-#define ISSUE_DROITE_X 80
-#define ISSUE_DROITE_Y 20
+#define ISSUE_GAUCHE_Y (HAUTEUR_PLATEAU / 2)
+#define ISSUE_DROITE_X LARGEUR_PLATEAU
+#define ISSUE_DROITE_Y (HAUTEUR_PLATEAU / 2)
 // touche d'arrêt du jeu
 #define STOP 'a'
 // nombre de pommes à manger pour gagner
 #define NB_POMMES 10
-// temporisation entre deux déplacements de chaque serpent en microsecondes 
-// (200 000 microseconces selon la consigne)
-#define ATTENTE 200000
+// nombre de tours par seconde par défaut : un déplacement de chaque serpent
+// toutes les 200 000 microsecondes selon la consigne
+#define FREQUENCE 5
+#define NANOS_PAR_SECONDE 1000000000L
+// taille du tampon d'écriture d'une image : au pire, chaque case de l'écran
+// est précédée de la séquence de déplacement du curseur "\033[yy;xxH"
+#define TAILLE_TAMPON_ECRAN (LARGEUR_PLATEAU * HAUTEUR_PLATEAU * 12 + 16)
+// options de la ligne de commande : mode sans affichage, mode tournoi (suivie du nombre
+// de parties), nombre de threads du tournoi et graine de la première partie du tournoi
+#define OPTION_SANS_AFFICHAGE "--sans-affichage"
+#define OPTION_TOURNOI "--tournoi"
+#define OPTION_THREADS "--threads"
+#define OPTION_GRAINE "--graine"
+// options du nombre de serpents d'une partie et de leurs stratégies
+#define OPTION_SERPENTS "--serpents"
+#define OPTION_STRATEGIES "--strategies"
+// option du nombre de tours par seconde d'une partie affichée (0 : sans attente)
+#define OPTION_FREQUENCE "--frequence"
+// option de mesure de la durée de chaque phase des tours de la partie
+#define OPTION_PROFIL "--profil"
+// options d'enregistrement d'une partie dans un fichier, de rejeu d'un fichier enregistré
+// et du tour où commence le rejeu (où il s'arrête en mode sans affichage)
+#define OPTION_ENREGISTRER "--enregistrer"
+#define OPTION_REJOUER "--rejouer"
+#define OPTION_TOUR "--tour"
+// option du nombre maximal de tours d'une partie (0 : sans limite)
+#define OPTION_TOURS_MAX "--tours-max"
+
+// fichier de rejeu : en-tête (tEnteteRejeu) commençant par MAGIE_REJEU, puis pour chaque
+// tour un octet par serpent, la direction choisie par le serpent pendant ce tour
+#define MAGIE_REJEU "SNK1"
+// un instantané de la partie est gardé tous les intervalleInstantanes tours rejoués, au plus
+// NB_INSTANTANES_MAX à la fois : l'intervalle double (en gardant un instantané sur deux)
+// quand ils sont tous utilisés
+#define INTERVALLE_INSTANTANES 256
+#define NB_INSTANTANES_MAX 64
+// touche de retour en arrière pendant un rejeu affiché, et nombre de tours reculés
+#define RECUL 'r'
+#define NB_TOURS_RECUL 50
+
+// phases d'un tour mesurées avec OPTION_PROFIL : choix des directions, vérification des
+// collisions, reste du déplacement (plateau, corps, pommes), affichage et attente. Le jeu
+// ne touche qu'au plateau : l'image du terminal en est tirée pendant la phase d'affichage
+#define PHASE_DIRECTION 0
+#define PHASE_COLLISION 1
+#define PHASE_PROGRESSION 2
+#define PHASE_AFFICHAGE 3
+#define PHASE_ATTENTE 4
+#define NB_PHASES 5
+// histogrammes des durées : 2^BITS_SOUS_SEAUX seaux par puissance de 2 de nanosecondes,
+// soit une précision relative de 1/32 de 1 ns jusqu'à 2^63 ns
+#define BITS_SOUS_SEAUX 5
+#define NB_SOUS_SEAUX (1 << BITS_SOUS_SEAUX)
+#define NB_SEAUX ((64 - BITS_SOUS_SEAUX + 1) * NB_SOUS_SEAUX)
+// lettres des stratégies : plus court chemin vers la pomme, gloutonne verticale d'abord
+// (stratégie d'origine du serpent 1) et gloutonne horizontale d'abord (celle du serpent 2)
+#define STRATEGIE_CHEMIN 'c'
+#define STRATEGIE_VERTICALE 'v'
+#define STRATEGIE_HORIZONTALE 'h'
+// stratégie prévoyante : essaie toutes les suites de ses propres déplacements sur
+// PROFONDEUR_RECHERCHE tours (les autres serpents gardant leur direction) et garde la
+// direction qui survit le plus longtemps, la plus proche de la pomme à égalité
+#define STRATEGIE_PREVOYANTE 'p'
+#define PROFONDEUR_RECHERCHE 4
+// capacité initiale du journal d'annulation de la recherche : nombre d'écritures notées et
+// taille des zones de plus de 8 octets notées (distances à la pomme, plans d'occupation),
+// doublées chaque fois que le journal est plein
+#define NB_ECRITURES_JOURNAL 4096
+#define TAILLE_BLOCS_JOURNAL 65536
+// nombre maximal de tours d'une partie par défaut (évite les parties sans fin en mode tournoi)
+#define NB_DEPLACEMENTS_MAX 20000
+// causes possibles de la fin d'un serpent
+#define CAUSE_AUCUNE 0
+#define CAUSE_BORDURE 1
+#define CAUSE_LUI_MEME 2
+#define CAUSE_ADVERSAIRE 3
+#define NB_CAUSES 4
 
 // définition des positions X et Y des pommes dans un tableau
 // et des positions des coins supérieurs gauches des pavés dans un tableau
@@ -87,276 +207,1637 @@ int lesPavesY[NB_PAVES] = { 4, 4, 33, 33, 14, 22};
 // définition d'un type pour le plateau
 typedef char tPlateau[LARGEUR_PLATEAU + 1][HAUTEUR_PLATEAU + 1];
 
-// déclaration des compteurs de pommes pour le serpent 1, 
-// pour le serpent 2 (globales car utilisées dans plusieurs fonctions)
-int nbPommes1 = 0;
-int nbPommes2 = 0;
+// définition d'un type pour un plan de bits du plateau : une ligne de bits par ordonnée,
+// pour traiter toute une ligne de cases en quelques opérations sur des mots de 64 bits
+typedef uint64_t tPlan[HAUTEUR_PLATEAU + 1][MOTS_PAR_LIGNE];
 
-// Total des déplacements des 2 serpents (globales car utilisées dans plusieurs fonctions)
-int deplacements1 = 0;
-int deplacements2 = 0;
+// définition d'un type pour les tableaux de travail des parcours du plateau (une case par
+// case ou un plan) : alloués avec la partie, la pile ne suffisant pas sur un grand plateau
+typedef struct
+{
+	// plus court chemin : déplacements à attendre avant que chaque case soit libre,
+	// déplacements pour l'atteindre, premier déplacement du chemin et file du parcours
+	int liberation[LARGEUR_PLATEAU + 1][HAUTEUR_PLATEAU + 1];
+	int distance[LARGEUR_PLATEAU + 1][HAUTEUR_PLATEAU + 1];
+	char premiere[LARGEUR_PLATEAU + 1][HAUTEUR_PLATEAU + 1];
+	int fileX[NB_CASES];
+	int fileY[NB_CASES];
+	// remplissages par plans (espaceLibre, calculerDistancesPomme)
+	tPlan atteint;
+	tPlan niveau;
+	tPlan voisins;
+} tParcours;
+
+// définition d'un type pour le corps d'un serpent : tampon circulaire d'anneaux.
+// La tête est à l'indice tete et l'anneau i (0 pour la tête) à l'indice tete - i
+// modulo TAILLE_MAX : avancer écrit la nouvelle tête sans décaler les autres anneaux
+typedef struct
+{
+	int lesX[TAILLE_MAX];
+	int lesY[TAILLE_MAX];
+	int tete;
+	int longueur;
+	// anneaux restant à ajouter après les pommes mangées
+	int aGrandir;
+	// grille d'occupation : bit à 1 pour chaque case occupée par un anneau du serpent
+	tPlan occupation;
+} tCorps;
+
+
+// définition d'un type pour l'histogramme des durées d'une phase, en nanosecondes :
+// chaque seau compte les durées d'un intervalle, de largeur proportionnelle à sa borne
+typedef struct
+{
+	long long seaux[NB_SEAUX];
+	long long nombre;
+	long long total;
+	long long max;
+} tHistogramme;
+
+// définition d'un type pour les mesures d'une partie : durée de chaque phase cumulée
+// pendant le tour courant, puis enregistrée une fois par tour dans son histogramme
+typedef struct
+{
+	tHistogramme phases[NB_PHASES];
+	long long dureesTour[NB_PHASES];
+	bool mesurees[NB_PHASES];
+	// instant de la fin de la dernière phase mesurée
+	long long debut;
+} tProfil;
+
+// définition d'un type pour une écriture du journal d'annulation : adresse et taille de la
+// zone modifiée, et son contenu d'avant, dans valeur jusqu'à 8 octets, sinon dans les
+// blocs du journal à partir de l'indice valeur
+typedef struct
+{
+	void *adresse;
+	size_t taille;
+	uint64_t valeur;
+} tEcriture;
+
+// définition d'un type pour le journal d'annulation d'une partie : chaque écriture d'un tour
+// joué avec le journal y note d'abord l'ancien contenu de la zone, ce qui permet d'annuler
+// les tours joués sans avoir copié la partie (tableaux agrandis au besoin, jamais réduits)
+typedef struct
+{
+	tEcriture *ecritures;
+	long nbEcritures;
+	long capaciteEcritures;
+	char *blocs;
+	size_t tailleBlocs;
+	size_t capaciteBlocs;
+} tJournal;
+
+// définition d'un type pour l'état d'une partie : tout ce qui change pendant la partie
+// y est regroupé pour que plusieurs parties puissent se jouer en même temps (mode tournoi)
+typedef struct sPartie tPartie;
+
+// définition d'un type pour la stratégie d'un serpent : retourne la direction choisie
+// par le serpent iSerpent pour son prochain déplacement
+typedef char (*tStrategie)(tPartie *partie, int iSerpent);
+
+struct sPartie
+{
+	// le plateau de jeu
+	tPlateau plateau;
+	// nombre de serpents de la partie, nombre de serpents encore en jeu
+	// et nombre en dessous duquel la partie s'arrête
+	int nbSerpents;
+	int nbVivants;
+	int nbVivantsMin;
+	// corps de chaque serpent
+	tCorps corps[NB_SERPENTS_MAX];
+	// tête, direction courante (HAUT, BAS, GAUCHE ou DROITE) et prochaine tête de chaque
+	// serpent, rangées dans des tableaux contigus pour résoudre les déplacements
+	// de tous les serpents dans les mêmes boucles
+	int tetesX[NB_SERPENTS_MAX];
+	int tetesY[NB_SERPENTS_MAX];
+	char directions[NB_SERPENTS_MAX];
+	int prochainesX[NB_SERPENTS_MAX];
+	int prochainesY[NB_SERPENTS_MAX];
+	// stratégie de chaque serpent
+	tStrategie strategies[NB_SERPENTS_MAX];
+	// compteurs de pommes et total des déplacements de chaque serpent
+	int nbPommes[NB_SERPENTS_MAX];
+	int deplacements[NB_SERPENTS_MAX];
+	// meilleur chemin vers la pomme courante (issue à emprunter ou CHEMIN_POMME)
+	int meilleuresDistances[NB_SERPENTS_MAX];
+	// positions des pommes de la partie et des coins supérieurs gauches de ses pavés
+	int lesPommesX[NB_POMMES];
+	int lesPommesY[NB_POMMES];
+	int lesPavesX[NB_PAVES];
+	int lesPavesY[NB_PAVES];
+	// nombre de déplacements de chaque case jusqu'à la pomme courante sur le plateau
+	// sans les serpents (-1 : case inaccessible), calculé à l'apparition de la pomme
+	int distancePomme[LARGEUR_PLATEAU + 1][HAUTEUR_PLATEAU + 1];
+	// plans de bits des cases infranchissables (bordures, pavés et bits hors du plateau),
+	// des cases occupées par les serpents en jeu et de la pomme : le jeu ne consulte
+	// qu'eux, le plateau ne sert plus qu'à l'affichage (caractère de chaque case)
+	tPlan murs;
+	tPlan serpents;
+	tPlan pommes;
+	// variables utiles aux interactions des serpents lors de la partie
+	bool vivants[NB_SERPENTS_MAX];
+	bool collisions[NB_SERPENTS_MAX];
+	int causes[NB_SERPENTS_MAX];
+	bool utiliserIssues[NB_SERPENTS_MAX];
+	bool gagne;
+	// nombre total de pommes mangées, serpent qui a mangé la pomme pendant
+	// le dernier tour (-1 : aucun) et nombre de tours joués
+	int nbPommesMangees;
+	int mangeur;
+	int tour;
+	// pommes tirées au hasard (mode tournoi) et état du générateur de la partie
+	bool pommesAleatoires;
+	unsigned int graine;
+	// mesures des phases des tours (NULL : pas de mesure)
+	tProfil *profil;
+	// journal où sont notées les écritures des tours joués (NULL : tours définitifs),
+	// et journal de la partie réservé à la recherche des stratégies (NULL : pas encore créé,
+	// il ne l'est qu'au premier coup d'un serpent prévoyant)
+	tJournal *journal;
+	tJournal *journalRecherche;
+	// tableaux de travail des parcours du plateau
+	tParcours *parcours;
+};
+
+// définition d'un type pour la cadence d'une partie affichée : les tours commencent à des
+// échéances fixes sur l'horloge CLOCK_MONOTONIC, espacées de periode nanosecondes,
+// quel que soit le temps passé à jouer et à afficher chaque tour
+typedef struct
+{
+	long periode;
+	struct timespec echeance;
+	// nombre de tours attendus et nombre de tours terminés après leur échéance
+	long nbTours;
+	long nbRetards;
+} tCadence;
+
+// définition d'un type pour l'en-tête d'un fichier de rejeu : tout ce qu'il faut, avec les
+// directions des tours, pour rejouer la partie à l'identique. Le nombre de tours se déduit
+// de la taille du fichier
+typedef struct
+{
+	char magie[4];
+	int32_t largeur;
+	int32_t hauteur;
+	int32_t nbSerpents;
+	// pavés, pommes et positions de départ tirés au hasard à partir de graine
+	int32_t aleatoire;
+	uint32_t graine;
+	// lettre de la stratégie de chaque serpent (pour information, le rejeu ne s'en sert pas)
+	char strategies[NB_SERPENTS_MAX];
+} tEnteteRejeu;
+
+// définition d'un type pour un rejeu : les directions de tous les tours du fichier
+// et les instantanés de la partie pris pendant le rejeu
+typedef struct
+{
+	tEnteteRejeu entete;
+	unsigned char *directions;
+	long nbTours;
+	// l'instantané i est la partie au tour i * intervalleInstantanes, alloué quand il est pris
+	size_t tailleInstantane;
+	char *instantanes[NB_INSTANTANES_MAX];
+	int nbInstantanes;
+	long intervalleInstantanes;
+} tRejeu;
+
+// définition d'un type pour les résultats cumulés d'un ensemble de parties
+typedef struct
+{
+	long victoires[NB_SERPENTS_MAX];
+	long nuls;
+	long abandons;
+	long deplacements[NB_SERPENTS_MAX];
+	long pommes[NB_SERPENTS_MAX];
+	long causes[NB_SERPENTS_MAX][NB_CAUSES];
+} tStatistiques;
+
+// définition d'un type pour un thread du tournoi et ses propres résultats
+typedef struct
+{
+	pthread_t thread;
+	tStatistiques stats;
+} tTravailleur;
+
+// caractère de la tête de chaque serpent : ni CORPS, ni POMME, ni BORDURE, ni VIDE
+const char TETES_SERPENTS[NB_SERPENTS_MAX + 1] = "123457890ABCDEFGHIJKLMNOPQRSTUVWYZabcdefghijklmnopqrstuvwxyz@$%&";
+
+// mode sans affichage : ni dessin, ni temporisation, ni lecture du clavier
+// (choisi au lancement avec OPTION_SANS_AFFICHAGE, sert aux simulations rapides)
+bool sansAffichage = false;
+
+// nombre de serpents de chaque partie et stratégies des serpents (une lettre par serpent,
+// reprises en boucle s'il y a plus de serpents que de lettres), fixés au lancement
+int nbSerpentsPartie = 2;
+const char *strategiesPartie = "c";
+
+// nombre de tours par seconde d'une partie affichée (0 : sans attente), fixé au lancement,
+// et cadence de la partie affichée
+long frequencePartie = FREQUENCE;
+tCadence cadencePartie;
+
+// nombre maximal de tours de chaque partie (0 : sans limite), fixé au lancement
+long toursMaxPartie = NB_DEPLACEMENTS_MAX;
+
+// mesure des phases demandée au lancement, et demande d'affichage des mesures
+// en cours de partie (posée par le signal SIGUSR1, traitée à la fin du tour)
+bool profilPartie = false;
+volatile sig_atomic_t demandeProfil = 0;
+
+// fichier où la partie est enregistrée (NULL : pas d'enregistrement)
+FILE *enregistrementPartie = NULL;
+
+// noms des phases dans l'affichage des mesures
+const char *NOMS_PHASES[NB_PHASES] = {"direction", "collision", "progression", "affichage", "attente"};
+
+// image actuellement affichée dans le terminal et image à afficher au prochain
+// rafraîchissement : afficher écrit dans ecranCible (dessinerPlateau y recopie
+// le plateau à chaque tour), rafraichirEcran n'envoie au terminal que les cases qui diffèrent entre les deux
+tPlateau ecranAffiche;
+tPlateau ecranCible;
+
+// paramètres du tournoi, fixés avant le lancement des threads,
+// et numéro de la prochaine partie à jouer, partagé par les threads
+long nbPartiesTournoi = 0;
+unsigned int graineTournoi = 0;
+atomic_long prochainePartie = 0;
+
+// lecture du clavier : le terminal passe une seule fois en mode brut pour toute la partie,
+// un thread attend les touches (au plus ATTENTE_CLAVIER millisecondes à la fois, pour voir
+// la demande d'arrêt) et les dépose dans une file circulaire de TAILLE_FILE_TOUCHES touches
+// (puissance de 2) que la boucle de jeu vide sans appel système
+#define ATTENTE_CLAVIER 100
+#define TAILLE_FILE_TOUCHES 64
+
+// file des touches sans verrou : seul le thread du clavier avance queue,
+// seule la boucle de jeu avance tete
+typedef struct
+{
+	char touches[TAILLE_FILE_TOUCHES];
+	atomic_uint tete;
+	atomic_uint queue;
+} tFileTouches;
+
+tFileTouches fileTouches;
+pthread_t threadClavier;
+atomic_bool arretClavier;
+bool clavierDemarre = false;
+// réglages du terminal avant le mode brut, remis à la sortie ou sur un signal d'arrêt
+struct termios terminalInitial;
+volatile sig_atomic_t terminalModifie = 0;
 
 /*
 * Déclaration des fonctions et procédures
 */
 // Fonctions plateau, pommes et pavés
-void initPlateau(tPlateau plateau, int lesX[], int lesY[]);
+void initPlateau(tPlateau plateau, int lesPavesX[], int lesPavesY[]);
 void dessinerPlateau(tPlateau plateau);
-void ajouterPomme(tPlateau plateau, int iPomme);
-void placerPaves(tPlateau plateau);
+void ajouterPomme(tPartie *partie);
+void placerPaves(tPlateau plateau, int lesPavesX[], int lesPavesY[]);
 void afficher(int, int, char);
-void effacer(int x, int y);
-
-// Fonctions relatives au serpent 1
-void dessinerSerpent1(int lesX1[], int lesY1[]);
-void directionSerpent1(int lesX1[], int lesY1[], tPlateau plateau, char *direction1, int x, int y, int lesX2[], int lesY2[], char directionSerpent2);
-bool verifierCollisionProchainDeplacement1(int lesX1[], int lesY1[], tPlateau plateau, char prochaineDirection1, int lesX2[], int lesY2[], char directionSerpent2);
-int calculDistance1(int lesX1[], int lesY1[], int pommeX, int pommeY);
-void progresser1(int lesX1[], int lesY1[], char direction1, tPlateau plateau, bool *collision1, bool *pommeMangee1, bool *utiliserIssue1);
-
-// Fonctions relatives au serpent 2
-void dessinerSerpent2(int lesX2[], int lesY2[]);
-void directionSerpent2(int lesX2[], int lesY2[], tPlateau plateau, char *direction2, int objectifX, int objectifY, int lesX1[], int lesY1[], char directionSerpent2);
-bool verifierCollisionProchainDeplacement2(int lesX2[], int lesY2[], tPlateau plateau, char prochaineDirection2, int lesX1[], int lesY1[], char directionSerpent1);
-int calculDistance2(int lesX2[], int lesY2[], int pommeX, int pommeY);
-void progresser2(int lesX2[], int lesY2[], char direction2, tPlateau plateau, bool *collision2, bool *pommeMangee2, bool *utiliserIssue2);
+void initEcran();
+void rafraichirEcran();
+int ajouterNombre(char tampon[], int n, int nombre);
+
+// Fonctions du corps des serpents
+int anneauX(tCorps *corps, int i);
+int anneauY(tCorps *corps, int i);
+void avancerCorps(tCorps *corps, int x, int y);
+bool caseOccupee(tCorps *corps, int x, int y);
+void occuperCase(tCorps *corps, int x, int y);
+void libererCase(tCorps *corps, int x, int y);
+
+// Fonctions des plans de bits
+bool lireBit(tPlan plan, int x, int y);
+void poserBit(tPlan plan, int x, int y);
+void oterBit(tPlan plan, int x, int y);
+bool caseLibre(tPartie *partie, int x, int y);
+void initMurs(tPartie *partie);
+void dilaterPlan(tPlan source, tPlan resultat, int premiere, int derniere);
+int espaceLibre(tPartie *partie, int x, int y, int limite);
+
+// Fonctions de recherche du plus court chemin
+bool directionPlusCourtChemin(tPartie *partie, int iSerpent, int objectifX, int objectifY, char *direction);
+void calculerDistancesPomme(tPartie *partie, int xPomme, int yPomme);
+bool directionDistancesPomme(tPartie *partie, int iSerpent, char *direction);
+void caseVoisine(int x, int y, char direction, int *voisinX, int *voisinY);
+
+// Fonctions relatives aux serpents
+char strategieChemin(tPartie *partie, int iSerpent);
+char strategieGloutonneVerticale(tPartie *partie, int iSerpent);
+char strategieGloutonneHorizontale(tPartie *partie, int iSerpent);
+char strategiePrevoyante(tPartie *partie, int iSerpent);
+int explorerDirection(tPartie *partie, int iSerpent, char direction, int profondeur);
+void objectifGlouton(tPartie *partie, int iSerpent, int *objectifX, int *objectifY);
+char directionVerticaleDAbord(tPartie *partie, int iSerpent, int x, int y);
+char directionHorizontaleDAbord(tPartie *partie, int iSerpent, int objectifX, int objectifY);
+bool verifierCollisionProchainDeplacement(tPartie *partie, int iSerpent, char prochaineDirection);
+bool caseVisee(tPartie *partie, int iSerpent, int x, int y);
+bool caseRivale(tPartie *partie, int iSerpent, int x, int y);
+char directionRivale(tPartie *partie, int iSerpent);
+int calculDistance(tPartie *partie, int iSerpent, int pommeX, int pommeY);
+void progresserSerpents(tPartie *partie);
+void retirerSerpent(tPartie *partie, int iSerpent);
+
+// Fonctions de déroulement d'une partie
+tPartie *allouerPartie();
+void libererPartie(tPartie *partie);
+void initPartie(tPartie *partie, bool aleatoire, unsigned int graine);
+tStrategie strategieNommee(char nom);
+void placerSerpent(tPartie *partie, int iSerpent, int xTete, int yTete, int sens, bool aleatoire);
+void jouerPartie(tPartie *partie);
+void jouerTour(tPartie *partie, char choix[]);
+
+// Fonctions de cadence
+void initCadence(tCadence *cadence, long frequence);
+void attendreTour(tCadence *cadence);
+
+// Fonctions de mesure des phases
+long long instantNs();
+void mesurerPhase(tPartie *partie, int phase);
+void terminerTour(tPartie *partie);
+void enregistrerDuree(tHistogramme *histogramme, long long duree);
+long long dureeQuantile(tHistogramme *histogramme, double quantile);
+void afficherProfil(tProfil *profil, FILE *flux);
+void demanderProfil(int numero);
+
+// Fonctions d'enregistrement et de rejeu
+void ouvrirEnregistrement(const char *chemin, bool aleatoire, unsigned int graine);
+void fermerEnregistrement();
+tRejeu *chargerRejeu(const char *chemin);
+void libererRejeu(tRejeu *rejeu);
+void debutRejeu(tRejeu *rejeu, tPartie *partie);
+bool avancerRejeu(tRejeu *rejeu, tPartie *partie);
+void allerAuTour(tRejeu *rejeu, tPartie *partie, long tour);
+void rejouerPartie(tRejeu *rejeu, tPartie *partie, long tourFin);
+void prendreInstantane(tRejeu *rejeu, tPartie *partie);
+void sauverInstantane(tPartie *partie, char *instantane);
+void restaurerInstantane(tPartie *partie, const char *instantane);
+
+// Fonctions du journal d'annulation
+tJournal *creerJournal();
+void noter(tPartie *partie, void *adresse, size_t taille);
+void noterBit(tPartie *partie, tPlan plan, int x, int y);
+void noterAvancee(tPartie *partie, tCorps *corps, int x, int y);
+long jouerCoup(tPartie *partie, char choix[]);
+void annulerCoup(tPartie *partie, long marque);
+
+// Fonctions du mode tournoi
+void tournoi(long nbParties, int nbThreads, unsigned int graine);
+void *travailleurTournoi(void *arg);
+void enregistrerPartie(tStatistiques *stats, tPartie *partie);
+void cumulerStatistiques(tStatistiques *total, tStatistiques *stats);
+void afficherStatistiques(tStatistiques *total, long nbParties, int nbThreads, unsigned int graine, double duree);
 
 // Fonctions boites noires
 void gotoxy(int x, int y);
-int kbhit();
-void disable_echo();
-void enable_echo();
-
-// programme principal du code contient l'initialisation du plateau des serpents 
-// ainsi que la boucle de jeu et de l'affichage de fin
-int main()
+void demarrerClavier();
+void arreterClavier();
+void restaurerTerminal();
+void signalArret(int numero);
+void *lireClavier(void *arg);
+void deposerTouche(char touche);
+bool lireTouche(char *touche);
+
+// programme principal du code contient le choix du mode d'exécution, l'initialisation
+// et l'affichage de la partie ainsi que l'affichage de fin
+int main(int argc, char *argv[])
 {
-	// tableaux contentant les coordonnées X et Y des corps des 2 serpents
-	int lesX1[TAILLE];
-	int lesY1[TAILLE];
-	int lesX2[TAILLE];
-	int lesY2[TAILLE];
+	// nombre de parties à jouer en mode tournoi (0 : partie classique)
+	long nbParties = 0;
+	// nombre de threads du tournoi (par défaut, un par coeur)
+	int nbThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	// graine de la première partie du tournoi, ou de la partie seule si elle est donnée
+	unsigned int graine = (unsigned int)time(NULL);
+	bool graineDonnee = false;
+	// fichiers d'enregistrement et de rejeu, et tour où commence le rejeu (-1 : au début)
+	const char *cheminEnregistrement = NULL;
+	const char *cheminRejeu = NULL;
+	long tourRejeu = -1;
+	tRejeu *rejeu = NULL;
+
+	// choix du mode d'exécution au lancement du programme
+	for (int i = 1 ; i < argc ; i++)
+	{
+		if (strcmp(argv[i], OPTION_SANS_AFFICHAGE) == 0)
+		{
+			sansAffichage = true;
+		}
+		else if (strcmp(argv[i], OPTION_TOURNOI) == 0 && i + 1 < argc)
+		{
+			nbParties = atol(argv[++i]);
+		}
+		else if (strcmp(argv[i], OPTION_THREADS) == 0 && i + 1 < argc)
+		{
+			nbThreads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], OPTION_GRAINE) == 0 && i + 1 < argc)
+		{
+			graine = (unsigned int)strtoul(argv[++i], NULL, 10);
+			graineDonnee = true;
+		}
+		else if (strcmp(argv[i], OPTION_SERPENTS) == 0 && i + 1 < argc)
+		{
+			nbSerpentsPartie = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], OPTION_STRATEGIES) == 0 && i + 1 < argc && argv[i + 1][0] != '\0')
+		{
+			strategiesPartie = argv[++i];
+		}
+		else if (strcmp(argv[i], OPTION_FREQUENCE) == 0 && i + 1 < argc)
+		{
+			frequencePartie = atol(argv[++i]);
+		}
+		else if (strcmp(argv[i], OPTION_PROFIL) == 0)
+		{
+			profilPartie = true;
+		}
+		else if (strcmp(argv[i], OPTION_ENREGISTRER) == 0 && i + 1 < argc)
+		{
+			cheminEnregistrement = argv[++i];
+		}
+		else if (strcmp(argv[i], OPTION_REJOUER) == 0 && i + 1 < argc)
+		{
+			cheminRejeu = argv[++i];
+		}
+		else if (strcmp(argv[i], OPTION_TOUR) == 0 && i + 1 < argc)
+		{
+			tourRejeu = atol(argv[++i]);
+		}
+		else if (strcmp(argv[i], OPTION_TOURS_MAX) == 0 && i + 1 < argc)
+		{
+			toursMaxPartie = atol(argv[++i]);
+		}
+	}
+	if (nbSerpentsPartie < 1)
+	{
+		nbSerpentsPartie = 1;
+	}
+	else if (nbSerpentsPartie > NB_SERPENTS_MAX)
+	{
+		nbSerpentsPartie = NB_SERPENTS_MAX;
+	}
+	if (frequencePartie < 0)
+	{
+		frequencePartie = 0;
+	}
+	if (toursMaxPartie < 0 || toursMaxPartie > INT_MAX)
+	{
+		toursMaxPartie = 0;
+	}
 
-	// représente la touche frappée par l'utilisateur : 
-    // attend la possible entrée de la touche arrêt (a)
-	char touche;
+	// le tournoi se joue toujours sans affichage
+	if (nbParties > 0)
+	{
+		sansAffichage = true;
+		tournoi(nbParties, nbThreads, graine);
+		return EXIT_SUCCESS;
+	}
 
-	// direction courante des serpents (HAUT, BAS, GAUCHE ou DROITE)
-	char direction1;
-	char direction2;
+	// temps CPU au début de la partie (affiché en mode sans affichage)
+	clock_t debut = clock();
 
-	// le plateau de jeu
-	tPlateau lePlateau;
-
-	//variables utiles aux interactions des serpents lors de la partie
-	bool collision1 = false;
-	bool collision2 = false;
-	bool gagne = false;
-	bool pommeMangee1 = false;
-	bool pommeMangee2 = false;
-	bool utiliserIssue1 = false;
-	bool utiliserIssue2 = false;
-
-	// initialisation de la position du serpent 1: positionnement de la
-	// tête en (X_INITIAL, Y_INITIAL_SERPENT_1), puis des anneaux à sa gauche
-	for (int i = 0 ; i < TAILLE ; i++)
+	// la partie : plateau, serpents et compteurs
+	tPartie *laPartie = allouerPartie();
+
+	// mise en place du plateau (bordures + pommes + pavés) et des serpents aux positions
+	// données en constantes, avec les pommes et les pavés des tableaux lesPommesX/lesPommesY
+	// et lesPavesX/lesPavesY, ou tirés au hasard comme en tournoi si la graine est donnée.
+	// Un rejeu reprend le nombre de serpents et la mise en place du fichier enregistré
+	if (cheminRejeu != NULL)
 	{
-		lesX1[i] = X_INITIAL - i;
-		lesY1[i] = Y_INITIAL_SERPENT_1;
+		rejeu = chargerRejeu(cheminRejeu);
+		initPartie(laPartie, rejeu->entete.aleatoire != 0, rejeu->entete.graine);
+		debutRejeu(rejeu, laPartie);
+		if (tourRejeu > 0)
+		{
+			allerAuTour(rejeu, laPartie, tourRejeu);
+		}
 	}
-	// initialisation de la position du serpent 2: positionnement de la
-	// tête en (X_INITIAL, Y_INITIAL_SERPENT_2), puis des anneaux à sa droite
-	for (int i = 0 ; i < TAILLE ; i++)
+	else
+	{
+		initPartie(laPartie, graineDonnee, graine);
+		if (cheminEnregistrement != NULL)
+		{
+			ouvrirEnregistrement(cheminEnregistrement, graineDonnee, graine);
+		}
+	}
+	if (profilPartie)
+	{
+		struct sigaction action;
+
+		laPartie->profil = calloc(1, sizeof(tProfil));
+		if (laPartie->profil == NULL)
+		{
+			perror("calloc");
+			exit(EXIT_FAILURE);
+		}
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = demanderProfil;
+		sigemptyset(&action.sa_mask);
+		action.sa_flags = SA_RESTART;
+		sigaction(SIGUSR1, &action, NULL);
+	}
+	if (!sansAffichage)
+	{
+		system("clear");
+		initEcran();
+		dessinerPlateau(laPartie->plateau);
+		rafraichirEcran();
+		demarrerClavier();
+	}
+
+	if (rejeu != NULL)
+	{
+		// sans affichage, le rejeu s'arrête au tour demandé
+		rejouerPartie(rejeu, laPartie, (sansAffichage && tourRejeu >= 0) ? tourRejeu : rejeu->nbTours);
+		libererRejeu(rejeu);
+	}
+	else
+	{
+		jouerPartie(laPartie);
+		fermerEnregistrement();
+	}
+
+	// en mode sans affichage, seuls les compteurs et le temps CPU sont affichés :
+	// les déplacements de chaque serpent, puis les pommes de chaque serpent
+	if (sansAffichage)
+	{
+		clock_t fin = clock();
+		for (int i = 0 ; i < laPartie->nbSerpents ; i++)
+		{
+			printf("%d ", laPartie->deplacements[i]);
+		}
+		for (int i = 0 ; i < laPartie->nbSerpents ; i++)
+		{
+			printf("%d ", laPartie->nbPommes[i]);
+		}
+		printf("%.6f\n", (double)(fin - debut) / CLOCKS_PER_SEC);
+		if (laPartie->profil != NULL)
+		{
+			afficherProfil(laPartie->profil, stderr);
+			free(laPartie->profil);
+		}
+		libererPartie(laPartie);
+		return EXIT_SUCCESS;
+	}
+
+    // se déplacer en dessous du tableau pour afficher les déplacement et nombre des pommes mangées par chaque serpent
+	arreterClavier();
+	gotoxy(1, HAUTEUR_PLATEAU + 1);
+
+	// afficher les performances du programme
+	for (int i = 0 ; i < laPartie->nbSerpents ; i++)
+	{
+		printf("Serpent %d : %d déplacements et %d pommes mangées\n", i + 1, laPartie->deplacements[i], laPartie->nbPommes[i]);
+	}
+	if (frequencePartie > 0)
 	{
-		lesX2[i] = X_INITIAL + i;
-		lesY2[i] = Y_INITIAL_SERPENT_2;
+		printf("%ld tours à %ld par seconde, %ld en retard\n",
+			cadencePartie.nbTours, frequencePartie, cadencePartie.nbRetards);
 	}
+	if (laPartie->profil != NULL)
+	{
+		afficherProfil(laPartie->profil, stderr);
+		free(laPartie->profil);
+	}
+	libererPartie(laPartie);
 
-	// mise en place du plateau (bordures + pommes + pavés)
-	initPlateau(lePlateau, lesX1, lesY1);
-	system("clear");
-	dessinerPlateau(lePlateau);
-	srand(time(NULL));
-	ajouterPomme(lePlateau, (nbPommes1 + nbPommes2));
+	return EXIT_SUCCESS;
+}
 
-	// initialisation des serpents et de leur direction initiale
-    // DROITE pour le serpent 1 et GAUCHE pour le serpent 2
-	dessinerSerpent1(lesX1, lesY1);
-	dessinerSerpent2(lesX2, lesY2);
-	disable_echo();
-	direction1 = DROITE;
-	direction2 = GAUCHE;
+/************************************************
+	   FONCTIONS DE DÉROULEMENT D'UNE PARTIE
+*************************************************/
+tPartie *allouerPartie()
+{
+	// une partie contient les corps de NB_SERPENTS_MAX serpents : trop gros pour la pile
+	tPartie *partie = malloc(sizeof(tPartie));
+	if (partie == NULL)
+	{
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	partie->journal = NULL;
+	partie->journalRecherche = NULL;
+	partie->parcours = malloc(sizeof(tParcours));
+	if (partie->parcours == NULL)
+	{
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	return partie;
+}
 
-	// calcul la meilleure distance à l'initialisation pour chaque serpent
-	int meilleurDistance1 = calculDistance1(lesX1, lesY1, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)]);
-	int meilleurDistance2 = calculDistance2(lesX2, lesY2, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)]);
+void libererPartie(tPartie *partie)
+{
+	if (partie->journalRecherche != NULL)
+	{
+		free(partie->journalRecherche->ecritures);
+		free(partie->journalRecherche->blocs);
+		free(partie->journalRecherche);
+	}
+	free(partie->parcours);
+	free(partie);
+}
 
-	// boucle de jeu des 2 serpents. Arret si touche STOP, si collision avec une bordure ou si toutes les pommes sont mangées
+void initPartie(tPartie *partie, bool aleatoire, unsigned int graine)
+{
+	int nbStrategies = (int)strlen(strategiesPartie);
+
+	// remise à zéro des compteurs et des indicateurs de la partie
+	partie->nbSerpents = nbSerpentsPartie;
+	partie->nbVivants = nbSerpentsPartie;
+	// seul en jeu, un serpent joue jusqu'à sa collision ; à plusieurs,
+	// la partie s'arrête quand il ne reste plus qu'un serpent en jeu
+	partie->nbVivantsMin = (nbSerpentsPartie > 1) ? 2 : 1;
+	partie->gagne = false;
+	partie->nbPommesMangees = 0;
+	partie->mangeur = -1;
+	partie->tour = 0;
+	partie->pommesAleatoires = aleatoire;
+	partie->graine = graine;
+	partie->profil = NULL;
+	partie->journal = NULL;
+
+	// pavés aux coordonnées données en constantes, ou tirés au hasard
+	// à l'écart des bordures pour ne jamais boucher une issue
+	for (int i = 0 ; i < NB_PAVES ; i++)
+	{
+		if (aleatoire)
+		{
+			partie->lesPavesX[i] = 3 + rand_r(&partie->graine) % (LARGEUR_PLATEAU - TAILLE_PAVES - 4);
+			partie->lesPavesY[i] = 3 + rand_r(&partie->graine) % (HAUTEUR_PLATEAU - TAILLE_PAVES - 4);
+		}
+		else
+		{
+			partie->lesPavesX[i] = lesPavesX[i];
+			partie->lesPavesY[i] = lesPavesY[i];
+		}
+	}
+	initPlateau(partie->plateau, partie->lesPavesX, partie->lesPavesY);
+	initMurs(partie);
+	memset(partie->serpents, 0, sizeof(partie->serpents));
+	memset(partie->pommes, 0, sizeof(partie->pommes));
+
+	for (int i = 0 ; i < partie->nbSerpents ; i++)
+	{
+		partie->nbPommes[i] = 0;
+		partie->deplacements[i] = 0;
+		partie->vivants[i] = true;
+		partie->collisions[i] = false;
+		partie->causes[i] = CAUSE_AUCUNE;
+		partie->utiliserIssues[i] = false;
+		partie->strategies[i] = strategieNommee(strategiesPartie[i % nbStrategies]);
+
+		// positions initiales : tête en (X_INITIAL, Y_INITIAL_SERPENT_1) et anneaux à sa gauche
+		// pour le serpent 1, tête en (X_INITIAL, Y_INITIAL_SERPENT_2) et anneaux à sa droite
+		// pour le serpent 2, ou têtes tirées au hasard sur des cases libres (toujours à partir
+		// du troisième serpent). Direction initiale : vers le côté opposé aux anneaux
+		int sens = (i % 2 == 0) ? -1 : 1;
+		placerSerpent(partie, i, X_INITIAL, (sens < 0) ? Y_INITIAL_SERPENT_1 : Y_INITIAL_SERPENT_2, sens, aleatoire || i >= 2);
+		partie->directions[i] = (sens < 0) ? DROITE : GAUCHE;
+	}
+
+	// première pomme puis meilleure distance à l'initialisation pour chaque serpent
+	ajouterPomme(partie);
+	for (int i = 0 ; i < partie->nbSerpents ; i++)
+	{
+		partie->meilleuresDistances[i] = calculDistance(partie, i, partie->lesPommesX[0], partie->lesPommesY[0]);
+	}
+}
+
+tStrategie strategieNommee(char nom)
+{
+	// stratégie correspondant à une lettre de OPTION_STRATEGIES
+	switch (nom)
+	{
+		case STRATEGIE_VERTICALE:
+			return strategieGloutonneVerticale;
+		case STRATEGIE_HORIZONTALE:
+			return strategieGloutonneHorizontale;
+		case STRATEGIE_PREVOYANTE:
+			return strategiePrevoyante;
+		default:
+			return strategieChemin;
+	}
+}
+
+void placerSerpent(tPartie *partie, int iSerpent, int xTete, int yTete, int sens, bool aleatoire)
+{
+	/*
+	* place la tête en (xTete, yTete) et les anneaux du côté donné par sens (-1 : à gauche,
+	* 1 : à droite). En placement aléatoire, la tête est tirée jusqu'à ce que toutes les
+	* cases du serpent soient libres. Le serpent est ensuite inscrit sur le plateau
+	*/
+	tCorps *corps = &partie->corps[iSerpent];
+	bool libre;
+	corps->tete = TAILLE - 1;
+	corps->longueur = TAILLE;
+	corps->aGrandir = 0;
 	do
 	{
-		/*
-        * déplacements du serpent 1
-        */
-		if (meilleurDistance1 == HAUT) // se dirige vers le trou du haut puis quand il s'est téléporté avance vers la pomme
+		if (aleatoire)
 		{
-			if (utiliserIssue1)
-			{
-				directionSerpent1(lesX1, lesY1, lePlateau, &direction1, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX2, lesY2, direction2);
-			}
-			else
-			{
-				directionSerpent1(lesX1, lesY1, lePlateau, &direction1, ISSUE_HAUT_X, ISSUE_HAUT_Y, lesX2, lesY2, direction2);
-			}
+			xTete = 2 + TAILLE + rand_r(&partie->graine) % (LARGEUR_PLATEAU - 2 * TAILLE - 2);
+			yTete = 2 + rand_r(&partie->graine) % (HAUTEUR_PLATEAU - 2);
 		}
-		if (meilleurDistance1 == BAS) // se dirige vers le trou du bas puis quand il s'est téléporté avance vers la pomme
+		libre = true;
+		// l'anneau i est rangé à l'indice tete - i du tampon
+		for (int i = 0 ; i < TAILLE ; i++)
 		{
-			if (utiliserIssue1)
-			{
-				directionSerpent1(lesX1, lesY1, lePlateau, &direction1, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX2, lesY2, direction2);
-			}
-			else
+			corps->lesX[corps->tete - i] = xTete + sens * i;
+			corps->lesY[corps->tete - i] = yTete;
+			if (!caseLibre(partie, anneauX(corps, i), anneauY(corps, i)))
 			{
-				directionSerpent1(lesX1, lesY1, lePlateau, &direction1, ISSUE_BAS_X, ISSUE_BAS_Y, lesX2, lesY2, direction2);
+				libre = false;
 			}
 		}
-		if (meilleurDistance1 == GAUCHE) // se dirige vers le trou de gauche puis quand il s'est téléporté avance vers la pomme
+	} while (aleatoire && !libre);
+
+	memset(corps->occupation, 0, sizeof(corps->occupation));
+	partie->tetesX[iSerpent] = anneauX(corps, 0);
+	partie->tetesY[iSerpent] = anneauY(corps, 0);
+	partie->plateau[anneauX(corps, 0)][anneauY(corps, 0)] = TETES_SERPENTS[iSerpent];
+	for (int i = 1 ; i < TAILLE ; i++)
+	{
+		partie->plateau[anneauX(corps, i)][anneauY(corps, i)] = CORPS;
+	}
+	for (int i = 0 ; i < TAILLE ; i++)
+	{
+		occuperCase(corps, anneauX(corps, i), anneauY(corps, i));
+		poserBit(partie->serpents, anneauX(corps, i), anneauY(corps, i));
+	}
+}
+
+void jouerPartie(tPartie *partie)
+{
+	// représente la touche frappée par l'utilisateur :
+    // attend la possible entrée de la touche arrêt (a)
+	char touche = '\0';
+	// directions choisies par les serpents pendant le tour
+	char choix[NB_SERPENTS_MAX];
+
+	// première échéance : un tour après le départ de la partie
+	if (!sansAffichage)
+	{
+		initCadence(&cadencePartie, frequencePartie);
+	}
+
+	if (partie->profil != NULL)
+	{
+		partie->profil->debut = instantNs();
+	}
+
+	// boucle de jeu des serpents. Arret si touche STOP, s'il ne reste plus assez de serpents en jeu,
+	// si toutes les pommes sont mangées ou si la partie atteint toursMaxPartie tours
+	do
+	{
+		// chaque serpent en jeu choisit sa direction selon sa stratégie. Les choix ne sont
+		// appliqués qu'une fois tous faits : aucun serpent ne voit le choix d'un autre
+		for (int i = 0 ; i < partie->nbSerpents ; i++)
 		{
-			if (utiliserIssue1)
-			{
-				directionSerpent1(lesX1, lesY1, lePlateau, &direction1, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX2, lesY2, direction2);
-			}
-			else
-			{
-				directionSerpent1(lesX1, lesY1, lePlateau, &direction1, ISSUE_GAUCHE_X, ISSUE_GAUCHE_Y, lesX2, lesY2, direction2);
-			}
+			choix[i] = partie->vivants[i] ? partie->strategies[i](partie, i) : partie->directions[i];
 		}
-		if (meilleurDistance1 == DROITE) // se dirige vers le trou de droite puis quand il s'est téléporté avance vers la pomme
+		mesurerPhase(partie, PHASE_DIRECTION);
+		if (enregistrementPartie != NULL)
 		{
-			if (utiliserIssue1)
-			{
-				directionSerpent1(lesX1, lesY1, lePlateau, &direction1, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX2, lesY2, direction2);
-			}
-			else
-			{
-				directionSerpent1(lesX1, lesY1, lePlateau, &direction1, ISSUE_DROITE_X, ISSUE_DROITE_Y, lesX2, lesY2, direction2);
-			}
+			fwrite(choix, 1, (size_t)partie->nbSerpents, enregistrementPartie);
+		}
+
+		jouerTour(partie, choix);
+		mesurerPhase(partie, PHASE_PROGRESSION);
+		// une seule écriture dans le terminal par tour, pour toutes les cases modifiées
+		if (!sansAffichage)
+		{
+			dessinerPlateau(partie->plateau);
+			rafraichirEcran();
+			mesurerPhase(partie, PHASE_AFFICHAGE);
 		}
-		if (meilleurDistance1 == CHEMIN_POMME) // sinon se dirige uniquement vers la pomme
+		// attente et lecture du clavier tant que la partie continue
+		if (!partie->gagne && !sansAffichage && partie->nbVivants >= partie->nbVivantsMin)
 		{
-			directionSerpent1(lesX1, lesY1, lePlateau, &direction1, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX2, lesY2, direction2);
+			attendreTour(&cadencePartie);
+			lireTouche(&touche);
+			mesurerPhase(partie, PHASE_ATTENTE);
 		}
+		terminerTour(partie);
+	} while (touche != STOP && partie->nbVivants >= partie->nbVivantsMin && !partie->gagne
+		&& (toursMaxPartie == 0 || partie->tour < toursMaxPartie));
+}
 
-		/* 
-        * déplacements du serpent 2
-        */
-		if (meilleurDistance2 == HAUT) // se dirige vers le trou du haut puis quand il s'est téléporté avance vers la pomme
+void jouerTour(tPartie *partie, char choix[])
+{
+	// applique les directions choisies, déplace tous les serpents en jeu en même temps,
+	// puis compte la pomme mangée et fait apparaître la suivante
+	noter(partie, partie->directions, (size_t)partie->nbSerpents);
+	memcpy(partie->directions, choix, (size_t)partie->nbSerpents);
+
+	// déplacement simultané de tous les serpents en jeu
+	progresserSerpents(partie);
+	noter(partie, &partie->tour, sizeof(partie->tour));
+	partie->tour++;
+
+	// Ajoute une pomme au compteur du serpent qui l'a mangée et arrete le jeu si score atteint 10
+	if (partie->mangeur != -1)
+	{
+		noter(partie, &partie->nbPommes[partie->mangeur], sizeof(int));
+		noter(partie, &partie->nbPommesMangees, sizeof(int));
+		partie->nbPommes[partie->mangeur]++;
+		partie->nbPommesMangees++;
+		if (partie->nbPommesMangees == NB_POMMES)
 		{
-			if (utiliserIssue2)
-			{
-				directionSerpent2(lesX2, lesY2, lePlateau, &direction2, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX1, lesY1, direction2);
-			}
-			else
-			{
-				directionSerpent2(lesX2, lesY2, lePlateau, &direction2, ISSUE_HAUT_X, ISSUE_HAUT_Y, lesX1, lesY1, direction2);
-			}
+			noter(partie, &partie->gagne, sizeof(bool));
+			noter(partie, &partie->utiliserIssues[partie->mangeur], sizeof(bool));
+			partie->gagne = true;
+			partie->utiliserIssues[partie->mangeur] = false;
 		}
-		if (meilleurDistance2 == BAS) // se dirige vers le trou du bas puis quand il s'est téléporté avance vers la pomme
+		else
 		{
-			if (utiliserIssue2)
-			{
-				directionSerpent2(lesX2, lesY2, lePlateau, &direction2, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX1, lesY1, direction2);
-			}
-			else
+			ajouterPomme(partie);
+			// recalcul la meilleure position de chaque serpent après l'apparition d'une nouvelle pomme
+			noter(partie, partie->meilleuresDistances, (size_t)partie->nbSerpents * sizeof(int));
+			for (int i = 0 ; i < partie->nbSerpents ; i++)
 			{
-				directionSerpent2(lesX2, lesY2, lePlateau, &direction2, ISSUE_BAS_X, ISSUE_BAS_Y, lesX1, lesY1, direction2);
+				partie->meilleuresDistances[i] = calculDistance(partie, i,
+					partie->lesPommesX[partie->nbPommesMangees], partie->lesPommesY[partie->nbPommesMangees]);
 			}
 		}
-		if (meilleurDistance2 == GAUCHE) // se dirige vers le trou de gauche puis quand il s'est téléporté avance vers la pomme
+	}
+}
+
+/************************************************
+	   		FONCTIONS DE CADENCE
+*************************************************/
+void initCadence(tCadence *cadence, long frequence)
+{
+	// période de 0 nanoseconde : sans attente, chaque tour commence dès la fin du précédent
+	cadence->periode = (frequence > 0) ? NANOS_PAR_SECONDE / frequence : 0;
+	cadence->nbTours = 0;
+	cadence->nbRetards = 0;
+	clock_gettime(CLOCK_MONOTONIC, &cadence->echeance);
+}
+
+void attendreTour(tCadence *cadence)
+{
+	/*
+	* attend l'échéance du tour suivant, fixée à une période après celle du tour courant
+	* et non après la fin de son calcul : le temps de jeu et d'affichage ne décale pas les
+	* tours suivants. Un tour terminé après son échéance est compté en retard ; s'il déborde
+	* d'une période entière ou plus, les échéances repartent de maintenant plutôt que
+	* d'enchaîner les tours en retard sans attente pour rattraper
+	*/
+	struct timespec maintenant;
+
+	cadence->nbTours++;
+	if (cadence->periode == 0)
+	{
+		return;
+	}
+	cadence->echeance.tv_nsec += cadence->periode;
+	while (cadence->echeance.tv_nsec >= NANOS_PAR_SECONDE)
+	{
+		cadence->echeance.tv_nsec -= NANOS_PAR_SECONDE;
+		cadence->echeance.tv_sec++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &maintenant);
+	long retard = (maintenant.tv_sec - cadence->echeance.tv_sec) * NANOS_PAR_SECONDE
+		+ (maintenant.tv_nsec - cadence->echeance.tv_nsec);
+	if (retard > 0)
+	{
+		cadence->nbRetards++;
+		if (retard >= cadence->periode)
 		{
-			if (utiliserIssue2)
+			cadence->echeance = maintenant;
+		}
+		return;
+	}
+	// échéance absolue : une attente interrompue par un signal reprend jusqu'à la même échéance
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &cadence->echeance, NULL) == EINTR)
+	{
+	}
+}
+
+/************************************************
+	   		FONCTIONS DE MESURE DES PHASES
+*************************************************/
+long long instantNs()
+{
+	struct timespec instant;
+
+	clock_gettime(CLOCK_MONOTONIC, &instant);
+	return (long long)instant.tv_sec * NANOS_PAR_SECONDE + instant.tv_nsec;
+}
+
+void mesurerPhase(tPartie *partie, int phase)
+{
+	// ajoute à la phase le temps écoulé depuis la fin de la phase mesurée précédente
+	tProfil *profil = partie->profil;
+	long long maintenant;
+
+	// les tours joués par la recherche d'une stratégie comptent dans le choix des directions
+	if (profil == NULL || partie->journal != NULL)
+	{
+		return;
+	}
+	maintenant = instantNs();
+	profil->dureesTour[phase] += maintenant - profil->debut;
+	profil->mesurees[phase] = true;
+	profil->debut = maintenant;
+}
+
+void terminerTour(tPartie *partie)
+{
+	/*
+	* enregistre la durée cumulée pendant le tour de chaque phase mesurée (la progression
+	* est mesurée en deux morceaux, de part et d'autre des collisions), puis affiche
+	* les mesures si le signal SIGUSR1 a été reçu pendant le tour
+	*/
+	tProfil *profil = partie->profil;
+
+	if (profil == NULL)
+	{
+		return;
+	}
+	for (int i = 0 ; i < NB_PHASES ; i++)
+	{
+		if (profil->mesurees[i])
+		{
+			enregistrerDuree(&profil->phases[i], profil->dureesTour[i]);
+			profil->dureesTour[i] = 0;
+			profil->mesurees[i] = false;
+		}
+	}
+	if (demandeProfil)
+	{
+		demandeProfil = 0;
+		afficherProfil(profil, stderr);
+	}
+}
+
+void enregistrerDuree(tHistogramme *histogramme, long long duree)
+{
+	/*
+	* les durées inférieures à NB_SOUS_SEAUX ont chacune leur seau ; au-delà, les durées
+	* de même bit de poids fort e se partagent NB_SOUS_SEAUX seaux, selon les
+	* BITS_SOUS_SEAUX bits qui suivent le bit de poids fort
+	*/
+	unsigned long long valeur = (duree > 0) ? (unsigned long long)duree : 0;
+	int seau;
+
+	if (valeur < NB_SOUS_SEAUX)
+	{
+		seau = (int)valeur;
+	}
+	else
+	{
+		int e = 63 - __builtin_clzll(valeur);
+		seau = (e - BITS_SOUS_SEAUX + 1) * NB_SOUS_SEAUX + (int)(valeur >> (e - BITS_SOUS_SEAUX)) - NB_SOUS_SEAUX;
+	}
+	histogramme->seaux[seau]++;
+	histogramme->nombre++;
+	histogramme->total += (long long)valeur;
+	if ((long long)valeur > histogramme->max)
+	{
+		histogramme->max = (long long)valeur;
+	}
+}
+
+long long dureeQuantile(tHistogramme *histogramme, double quantile)
+{
+	// borne haute du seau qui contient la durée de rang quantile * nombre,
+	// sans dépasser la durée maximale mesurée
+	long long rang = (long long)(quantile * (double)histogramme->nombre);
+	long long cumul = 0;
+
+	if (rang >= histogramme->nombre)
+	{
+		return histogramme->max;
+	}
+	for (int seau = 0 ; seau < NB_SEAUX ; seau++)
+	{
+		cumul += histogramme->seaux[seau];
+		if (cumul > rang)
+		{
+			int groupe = seau / NB_SOUS_SEAUX;
+			long long borne;
+			if (groupe == 0)
 			{
-				directionSerpent2(lesX2, lesY2, lePlateau, &direction2, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX1, lesY1, direction2);
+				borne = seau;
 			}
 			else
 			{
-				directionSerpent2(lesX2, lesY2, lePlateau, &direction2, ISSUE_GAUCHE_X, ISSUE_GAUCHE_Y, lesX1, lesY1, direction2);
+				long long largeur = 1LL << (groupe - 1);
+				borne = (long long)(NB_SOUS_SEAUX + seau % NB_SOUS_SEAUX) * largeur + largeur - 1;
 			}
+			return (borne < histogramme->max) ? borne : histogramme->max;
 		}
-		if (meilleurDistance2 == DROITE) // se dirige vers le trou de droite puis quand il s'est téléporté avance vers la pomme
+	}
+	return histogramme->max;
+}
+
+void afficherProfil(tProfil *profil, FILE *flux)
+{
+	// nombre de tours mesurés, puis durée moyenne, médiane, 99e centile et maximale
+	// de chaque phase en microsecondes
+	fprintf(flux, "%-12s %10s %12s %12s %12s %12s\n", "phase", "tours", "moyenne(us)", "p50(us)", "p99(us)", "max(us)");
+	for (int i = 0 ; i < NB_PHASES ; i++)
+	{
+		tHistogramme *histogramme = &profil->phases[i];
+		if (histogramme->nombre == 0)
 		{
-			if (utiliserIssue2)
-			{
-				directionSerpent2(lesX2, lesY2, lePlateau, &direction2, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX1, lesY1, direction2);
-			}
-			else
+			continue;
+		}
+		fprintf(flux, "%-12s %10lld %12.3f %12.3f %12.3f %12.3f\n", NOMS_PHASES[i], histogramme->nombre,
+			(double)histogramme->total / (double)histogramme->nombre / 1000.0,
+			(double)dureeQuantile(histogramme, 0.50) / 1000.0,
+			(double)dureeQuantile(histogramme, 0.99) / 1000.0,
+			(double)histogramme->max / 1000.0);
+	}
+	fflush(flux);
+}
+
+void demanderProfil(int numero)
+{
+	// seul un indicateur est posé ici : l'affichage se fait à la fin du tour en cours
+	(void)numero;
+	demandeProfil = 1;
+}
+
+/************************************************
+	   FONCTIONS D'ENREGISTREMENT ET DE REJEU
+*************************************************/
+void ouvrirEnregistrement(const char *chemin, bool aleatoire, unsigned int graine)
+{
+	// écrit l'en-tête ; les directions de chaque tour sont ajoutées par jouerPartie
+	// et passent par le tampon du fichier, sans appel système à chaque tour
+	tEnteteRejeu entete;
+	int nbStrategies = (int)strlen(strategiesPartie);
+
+	memset(&entete, 0, sizeof(entete));
+	memcpy(entete.magie, MAGIE_REJEU, sizeof(entete.magie));
+	entete.largeur = LARGEUR_PLATEAU;
+	entete.hauteur = HAUTEUR_PLATEAU;
+	entete.nbSerpents = nbSerpentsPartie;
+	entete.aleatoire = aleatoire;
+	entete.graine = graine;
+	for (int i = 0 ; i < nbSerpentsPartie ; i++)
+	{
+		entete.strategies[i] = strategiesPartie[i % nbStrategies];
+	}
+
+	enregistrementPartie = fopen(chemin, "wb");
+	if (enregistrementPartie == NULL)
+	{
+		perror(chemin);
+		exit(EXIT_FAILURE);
+	}
+	if (fwrite(&entete, sizeof(entete), 1, enregistrementPartie) != 1)
+	{
+		perror(chemin);
+		exit(EXIT_FAILURE);
+	}
+}
+
+void fermerEnregistrement()
+{
+	if (enregistrementPartie != NULL)
+	{
+		if (fclose(enregistrementPartie) != 0)
+		{
+			perror("fclose");
+		}
+		enregistrementPartie = NULL;
+	}
+}
+
+tRejeu *chargerRejeu(const char *chemin)
+{
+	/*
+	* lit tout le fichier de rejeu en mémoire et vérifie son en-tête et ses directions.
+	* Le nombre de serpents et les stratégies de la partie sont repris de l'en-tête
+	*/
+	static char strategies[NB_SERPENTS_MAX + 1];
+	FILE *fichier = fopen(chemin, "rb");
+	tRejeu *rejeu = calloc(1, sizeof(tRejeu));
+	long taille;
+
+	if (fichier == NULL || rejeu == NULL)
+	{
+		perror(chemin);
+		exit(EXIT_FAILURE);
+	}
+	if (fread(&rejeu->entete, sizeof(tEnteteRejeu), 1, fichier) != 1
+		|| memcmp(rejeu->entete.magie, MAGIE_REJEU, sizeof(rejeu->entete.magie)) != 0
+		|| rejeu->entete.largeur != LARGEUR_PLATEAU || rejeu->entete.hauteur != HAUTEUR_PLATEAU
+		|| rejeu->entete.nbSerpents < 1 || rejeu->entete.nbSerpents > NB_SERPENTS_MAX)
+	{
+		fprintf(stderr, "%s : fichier de rejeu invalide\n", chemin);
+		exit(EXIT_FAILURE);
+	}
+	fseek(fichier, 0, SEEK_END);
+	taille = ftell(fichier) - (long)sizeof(tEnteteRejeu);
+	fseek(fichier, (long)sizeof(tEnteteRejeu), SEEK_SET);
+
+	// un tour incomplet à la fin du fichier (partie interrompue) est ignoré
+	rejeu->nbTours = taille / rejeu->entete.nbSerpents;
+	rejeu->directions = malloc((size_t)(rejeu->nbTours * rejeu->entete.nbSerpents) + 1);
+	if (rejeu->directions == NULL)
+	{
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	if (fread(rejeu->directions, 1, (size_t)(rejeu->nbTours * rejeu->entete.nbSerpents), fichier)
+		!= (size_t)(rejeu->nbTours * rejeu->entete.nbSerpents))
+	{
+		perror(chemin);
+		exit(EXIT_FAILURE);
+	}
+	fclose(fichier);
+	for (long i = 0 ; i < rejeu->nbTours * rejeu->entete.nbSerpents ; i++)
+	{
+		if (rejeu->directions[i] < HAUT || rejeu->directions[i] > DROITE)
+		{
+			fprintf(stderr, "%s : direction invalide au tour %ld\n", chemin, i / rejeu->entete.nbSerpents);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	nbSerpentsPartie = rejeu->entete.nbSerpents;
+	memcpy(strategies, rejeu->entete.strategies, NB_SERPENTS_MAX);
+	strategies[nbSerpentsPartie] = '\0';
+	strategiesPartie = (strategies[0] != '\0') ? strategies : "c";
+
+	// un instantané ne contient que les corps des serpents de la partie
+	rejeu->tailleInstantane = sizeof(tPartie) - (size_t)(NB_SERPENTS_MAX - nbSerpentsPartie) * sizeof(tCorps);
+	return rejeu;
+}
+
+void libererRejeu(tRejeu *rejeu)
+{
+	free(rejeu->directions);
+	for (int i = 0 ; i < NB_INSTANTANES_MAX ; i++)
+	{
+		free(rejeu->instantanes[i]);
+	}
+	free(rejeu);
+}
+
+void debutRejeu(tRejeu *rejeu, tPartie *partie)
+{
+	// la partie vient d'être initialisée : elle devient l'instantané du tour 0
+	rejeu->intervalleInstantanes = INTERVALLE_INSTANTANES;
+	rejeu->nbInstantanes = 0;
+	prendreInstantane(rejeu, partie);
+}
+
+bool avancerRejeu(tRejeu *rejeu, tPartie *partie)
+{
+	/*
+	* joue le tour suivant avec les directions enregistrées, sans consulter les stratégies.
+	* Retourne false si tous les tours du fichier ont été joués
+	*/
+	if (partie->tour >= rejeu->nbTours)
+	{
+		return false;
+	}
+	jouerTour(partie, (char *)&rejeu->directions[partie->tour * partie->nbSerpents]);
+
+	// instantané du tour si c'est le premier tour rejoué après le dernier instantané
+	if (partie->tour == rejeu->nbInstantanes * rejeu->intervalleInstantanes)
+	{
+		if (rejeu->nbInstantanes == NB_INSTANTANES_MAX)
+		{
+			// les instantanés pairs passent au début, les impairs sont réutilisés ensuite
+			for (int i = 1 ; i < NB_INSTANTANES_MAX / 2 ; i++)
 			{
-				directionSerpent2(lesX2, lesY2, lePlateau, &direction2, ISSUE_DROITE_X, ISSUE_DROITE_Y, lesX1, lesY1, direction2);
+				char *impair = rejeu->instantanes[i];
+				rejeu->instantanes[i] = rejeu->instantanes[2 * i];
+				rejeu->instantanes[2 * i] = impair;
 			}
+			rejeu->nbInstantanes = NB_INSTANTANES_MAX / 2;
+			rejeu->intervalleInstantanes *= 2;
+		}
+		prendreInstantane(rejeu, partie);
+	}
+	return true;
+}
+
+void allerAuTour(tRejeu *rejeu, tPartie *partie, long tour)
+{
+	/*
+	* amène la partie au tour donné : repart du dernier instantané pris avant ce tour
+	* s'il faut revenir en arrière ou s'il est plus avancé que la partie, puis rejoue
+	* les tours qui manquent
+	*/
+	long iInstantane;
+
+	if (tour < 0)
+	{
+		tour = 0;
+	}
+	else if (tour > rejeu->nbTours)
+	{
+		tour = rejeu->nbTours;
+	}
+	iInstantane = tour / rejeu->intervalleInstantanes;
+	if (iInstantane >= rejeu->nbInstantanes)
+	{
+		iInstantane = rejeu->nbInstantanes - 1;
+	}
+	if (tour < partie->tour || iInstantane * rejeu->intervalleInstantanes > partie->tour)
+	{
+		restaurerInstantane(partie, rejeu->instantanes[iInstantane]);
+	}
+	while (partie->tour < tour)
+	{
+		avancerRejeu(rejeu, partie);
+	}
+}
+
+void rejouerPartie(tRejeu *rejeu, tPartie *partie, long tourFin)
+{
+	/*
+	* rejoue les tours enregistrés jusqu'au tour tourFin. Affiché, le rejeu suit la cadence
+	* de OPTION_FREQUENCE (0 : au plus vite), s'arrête sur la touche STOP et recule de
+	* NB_TOURS_RECUL tours sur la touche RECUL. Avec OPTION_PROFIL, les phases sont mesurées
+	* comme dans jouerPartie, sans le choix des directions, lues dans le fichier ; un recul
+	* compte dans le tour où la touche a été lue
+	*/
+	char touche = '\0';
+
+	if (partie->profil != NULL)
+	{
+		partie->profil->debut = instantNs();
+	}
+	if (sansAffichage)
+	{
+		while (partie->tour < tourFin && avancerRejeu(rejeu, partie))
+		{
+			mesurerPhase(partie, PHASE_PROGRESSION);
+			terminerTour(partie);
 		}
-		if (meilleurDistance2 == CHEMIN_POMME) // sinon se dirige uniquement vers la pomme
+		return;
+	}
+	initCadence(&cadencePartie, frequencePartie);
+	while (touche != STOP && partie->tour < tourFin)
+	{
+		if (touche == RECUL)
 		{
-			directionSerpent2(lesX2, lesY2, lePlateau, &direction2, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)], lesX1, lesY1, direction2);
+			allerAuTour(rejeu, partie, partie->tour - NB_TOURS_RECUL);
 		}
+		else
+		{
+			avancerRejeu(rejeu, partie);
+		}
+		mesurerPhase(partie, PHASE_PROGRESSION);
+		// le plateau contient les serpents : le redessiner redessine tout l'écran
+		dessinerPlateau(partie->plateau);
+		rafraichirEcran();
+		mesurerPhase(partie, PHASE_AFFICHAGE);
+		attendreTour(&cadencePartie);
+		touche = '\0';
+		lireTouche(&touche);
+		mesurerPhase(partie, PHASE_ATTENTE);
+		terminerTour(partie);
+	}
+}
+
+void prendreInstantane(tRejeu *rejeu, tPartie *partie)
+{
+	// instantané suivant du rejeu : sa place n'est allouée qu'au premier passage
+	char **instantane = &rejeu->instantanes[rejeu->nbInstantanes];
+	if (*instantane == NULL)
+	{
+		*instantane = malloc(rejeu->tailleInstantane);
+		if (*instantane == NULL)
+		{
+			perror("malloc");
+			exit(EXIT_FAILURE);
+		}
+	}
+	sauverInstantane(partie, *instantane);
+	rejeu->nbInstantanes++;
+}
+
+void sauverInstantane(tPartie *partie, char *instantane)
+{
+	// copie la partie sans les corps des serpents qui n'en font pas partie :
+	// début de la structure, corps des serpents de la partie, fin de la structure
+	size_t debutCorps = offsetof(tPartie, corps);
+	size_t tailleCorps = (size_t)partie->nbSerpents * sizeof(tCorps);
+	size_t finCorps = offsetof(tPartie, corps) + sizeof(partie->corps);
+
+	memcpy(instantane, partie, debutCorps);
+	memcpy(instantane + debutCorps, partie->corps, tailleCorps);
+	memcpy(instantane + debutCorps + tailleCorps, (char *)partie + finCorps, sizeof(tPartie) - finCorps);
+}
 
-		// deplacement du serpent à chaque fois et incrémentation du compteur de déplacements
-		progresser1(lesX1, lesY1, direction1, lePlateau, &collision1, &pommeMangee1, &utiliserIssue1);
-		progresser2(lesX2, lesY2, direction2, lePlateau, &collision2, &pommeMangee2, &utiliserIssue2);
+void restaurerInstantane(tPartie *partie, const char *instantane)
+{
+	/*
+	* le nombre de serpents de l'instantané est celui de la partie. Les pointeurs de la
+	* partie (mesures, journaux et tableaux de travail) ne font pas partie de l'état du jeu : ils sont gardés,
+	* l'instantané pouvant dater d'avant leur allocation
+	*/
+	size_t debutCorps = offsetof(tPartie, corps);
+	size_t tailleCorps = (size_t)partie->nbSerpents * sizeof(tCorps);
+	size_t finCorps = offsetof(tPartie, corps) + sizeof(partie->corps);
+	tProfil *profil = partie->profil;
+	tJournal *journal = partie->journal;
+	tJournal *journalRecherche = partie->journalRecherche;
+	tParcours *parcours = partie->parcours;
+
+	memcpy(partie, instantane, debutCorps);
+	memcpy(partie->corps, instantane + debutCorps, tailleCorps);
+	memcpy((char *)partie + finCorps, instantane + debutCorps + tailleCorps, sizeof(tPartie) - finCorps);
+	partie->profil = profil;
+	partie->journal = journal;
+	partie->journalRecherche = journalRecherche;
+	partie->parcours = parcours;
+}
+
+/************************************************
+	   	FONCTIONS DU JOURNAL D'ANNULATION
+*************************************************/
+tJournal *creerJournal()
+{
+	tJournal *journal = malloc(sizeof(tJournal));
+	if (journal != NULL)
+	{
+		journal->ecritures = malloc(NB_ECRITURES_JOURNAL * sizeof(tEcriture));
+		journal->blocs = malloc(TAILLE_BLOCS_JOURNAL);
+	}
+	if (journal == NULL || journal->ecritures == NULL || journal->blocs == NULL)
+	{
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	journal->nbEcritures = 0;
+	journal->capaciteEcritures = NB_ECRITURES_JOURNAL;
+	journal->tailleBlocs = 0;
+	journal->capaciteBlocs = TAILLE_BLOCS_JOURNAL;
+	return journal;
+}
 
-		// Ajoute une pomme au compteur de pomme quand elle est mangée et arrete le jeu si score atteint 10
-		if (pommeMangee1) // si le serpent 1 mange une pomme
+void noter(tPartie *partie, void *adresse, size_t taille)
+{
+	// note le contenu de la zone avant qu'elle soit modifiée, si un journal est en cours
+	tJournal *journal = partie->journal;
+	tEcriture *ecriture;
+
+	if (journal == NULL)
+	{
+		return;
+	}
+	// journal plein : ses tableaux doublent (les écritures repèrent leurs blocs par indice)
+	if (journal->nbEcritures == journal->capaciteEcritures)
+	{
+		tEcriture *ecritures = realloc(journal->ecritures, 2 * journal->capaciteEcritures * sizeof(tEcriture));
+		if (ecritures == NULL)
+		{
+			perror("realloc");
+			exit(EXIT_FAILURE);
+		}
+		journal->ecritures = ecritures;
+		journal->capaciteEcritures *= 2;
+	}
+	if (taille > sizeof(uint64_t) && journal->tailleBlocs + taille > journal->capaciteBlocs)
+	{
+		size_t capacite = journal->capaciteBlocs;
+		char *blocs;
+		while (journal->tailleBlocs + taille > capacite)
+		{
+			capacite *= 2;
+		}
+		blocs = realloc(journal->blocs, capacite);
+		if (blocs == NULL)
+		{
+			perror("realloc");
+			exit(EXIT_FAILURE);
+		}
+		journal->blocs = blocs;
+		journal->capaciteBlocs = capacite;
+	}
+	ecriture = &journal->ecritures[journal->nbEcritures++];
+	ecriture->adresse = adresse;
+	ecriture->taille = taille;
+	if (taille <= sizeof(uint64_t))
+	{
+		memcpy(&ecriture->valeur, adresse, taille);
+	}
+	else
+	{
+		ecriture->valeur = journal->tailleBlocs;
+		memcpy(journal->blocs + journal->tailleBlocs, adresse, taille);
+		journal->tailleBlocs += taille;
+	}
+}
+
+void noterBit(tPartie *partie, tPlan plan, int x, int y)
+{
+	// note le mot de 64 bits qui contient la case (x, y) du plan
+	noter(partie, &plan[y][x / 64], sizeof(uint64_t));
+}
+
+void noterAvancee(tPartie *partie, tCorps *corps, int x, int y)
+{
+	// note tout ce que avancerCorps(corps, x, y) va modifier : longueur, anneaux à ajouter,
+	// indice de la tête, case du tampon de la nouvelle tête, mots de la grille d'occupation
+	// de l'ancienne queue et de la nouvelle tête
+	int suivante = (corps->tete + 1) & MASQUE_ANNEAUX;
+
+	noter(partie, &corps->longueur, sizeof(int));
+	noter(partie, &corps->aGrandir, sizeof(int));
+	noter(partie, &corps->tete, sizeof(int));
+	noter(partie, &corps->lesX[suivante], sizeof(int));
+	noter(partie, &corps->lesY[suivante], sizeof(int));
+	noterBit(partie, corps->occupation, anneauX(corps, corps->longueur - 1), anneauY(corps, corps->longueur - 1));
+	noterBit(partie, corps->occupation, x, y);
+}
+
+long jouerCoup(tPartie *partie, char choix[])
+{
+	/*
+	* joue un tour avec les directions choisies en notant ses écritures dans le journal
+	* de la partie (qui doit être en cours), sans rien afficher. Retourne la marque
+	* à donner à annulerCoup pour revenir à l'état d'avant ce tour
+	*/
+	long marque = partie->journal->nbEcritures;
+
+	jouerTour(partie, choix);
+	return marque;
+}
+
+void annulerCoup(tPartie *partie, long marque)
+{
+	// remet les zones notées depuis la marque, de la plus récente à la plus ancienne
+	tJournal *journal = partie->journal;
+
+	while (journal->nbEcritures > marque)
+	{
+		tEcriture *ecriture = &journal->ecritures[--journal->nbEcritures];
+		if (ecriture->taille <= sizeof(uint64_t))
+		{
+			memcpy(ecriture->adresse, &ecriture->valeur, ecriture->taille);
+		}
+		else
+		{
+			journal->tailleBlocs = ecriture->valeur;
+			memcpy(ecriture->adresse, journal->blocs + ecriture->valeur, ecriture->taille);
+		}
+	}
+}
+
+/************************************************
+	   		FONCTIONS DU MODE TOURNOI
+*************************************************/
+void tournoi(long nbParties, int nbThreads, unsigned int graine)
+{
+	/*
+	* joue nbParties parties indépendantes sur nbThreads threads. Chaque thread
+	* cumule ses résultats dans ses propres statistiques, fusionnées à la fin :
+	* les parties ne partagent rien, à part le compteur de parties à jouer
+	*/
+	if (nbThreads < 1)
+	{
+		nbThreads = 1;
+	}
+	tTravailleur *travailleurs = calloc((size_t)nbThreads, sizeof(tTravailleur));
+	if (travailleurs == NULL)
+	{
+		perror("calloc");
+		exit(EXIT_FAILURE);
+	}
+	tStatistiques total = {0};
+	struct timespec debut, fin;
+
+	nbPartiesTournoi = nbParties;
+	graineTournoi = graine;
+	atomic_store(&prochainePartie, 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &debut);
+	for (int i = 0 ; i < nbThreads ; i++)
+	{
+		if (pthread_create(&travailleurs[i].thread, NULL, travailleurTournoi, &travailleurs[i]) != 0)
+		{
+			perror("pthread_create");
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (int i = 0 ; i < nbThreads ; i++)
+	{
+		pthread_join(travailleurs[i].thread, NULL);
+		cumulerStatistiques(&total, &travailleurs[i].stats);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &fin);
+	free(travailleurs);
+
+	double duree = (double)(fin.tv_sec - debut.tv_sec) + (double)(fin.tv_nsec - debut.tv_nsec) / 1e9;
+	afficherStatistiques(&total, nbParties, nbThreads, graine, duree);
+}
+
+void *travailleurTournoi(void *arg)
+{
+	// chaque thread prend la prochaine partie à jouer tant qu'il en reste
+	tTravailleur *travailleur = arg;
+	tPartie *partie = allouerPartie();
+	long iPartie;
+
+	while ((iPartie = atomic_fetch_add(&prochainePartie, 1)) < nbPartiesTournoi)
+	{
+		// la graine de la partie ne dépend que de son numéro : le tournoi est reproductible
+		initPartie(partie, true, graineTournoi + (unsigned int)iPartie);
+		jouerPartie(partie);
+		enregistrerPartie(&travailleur->stats, partie);
+	}
+	libererPartie(partie);
+	return NULL;
+}
+
+void enregistrerPartie(tStatistiques *stats, tPartie *partie)
+{
+	/*
+	* un serpent qui entre en collision perd : parmi les serpents encore en jeu, celui
+	* qui a mangé le plus de pommes gagne. Égalité, ou aucun serpent en jeu : match nul
+	*/
+	int gagnant = -1;
+	bool egalite = false;
+	for (int i = 0 ; i < partie->nbSerpents ; i++)
+	{
+		if (!partie->vivants[i])
 		{
-			nbPommes1++;
-			if ((nbPommes1 + nbPommes2) == NB_POMMES)
-            {
-				gagne = true;
-				utiliserIssue1 = false;
-			}
-			if (!gagne) // si le serpent 1 mange une pomme mais pas celle de la fin de partie
-			{
-				ajouterPomme(lePlateau, (nbPommes1 + nbPommes2));
-				// recalcul la meilleure position après l'apparition d'une nouvelle pomme
-				meilleurDistance1 = calculDistance1(lesX1, lesY1, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)]);
-				pommeMangee1 = false;
-			}
+			continue;
 		}
-		else if (pommeMangee2) // si le serpent 2 mange une pomme
-        { 
-			nbPommes2++;
-			if ((nbPommes1 + nbPommes2) == NB_POMMES)
-            {
-				gagne = true;
-				utiliserIssue2 = false;
-			}
-			if (!gagne) // si le serpent 2 mange une pomme mais pas celle de la fin de partie
-			{
-				ajouterPomme(lePlateau, (nbPommes1 + nbPommes2));
-				// recalcul la meilleure position après l'apparition d'une nouvelle pomme
-				meilleurDistance2 = calculDistance2(lesX2, lesY2, lesPommesX[(nbPommes1 + nbPommes2)], lesPommesY[(nbPommes1 + nbPommes2)]);
-				pommeMangee2 = false;
-			}
+		if (gagnant == -1 || partie->nbPommes[i] > partie->nbPommes[gagnant])
+		{
+			gagnant = i;
+			egalite = false;
 		}
-		if (!gagne) // Si aucune collision n'est détectée quand les 2 serpents se déplacent 1 fois
+		else if (partie->nbPommes[i] == partie->nbPommes[gagnant])
 		{
-			if (!collision1 && !collision2)
-			{
-				usleep(ATTENTE);
-				if (kbhit() == 1)
-				{
-					touche = getchar();
-				}
-			}
+			egalite = true;
 		}
-	} while (touche != STOP && !collision1 && !collision2 && !gagne); 
-
-    // se déplacer en dessous du tableau pour afficher les déplacement et nombre des pommes mangées par chaque serpent
-	enable_echo();
-	gotoxy(1, HAUTEUR_PLATEAU + 1);
+	}
+	if (gagnant != -1 && !egalite)
+	{
+		stats->victoires[gagnant]++;
+	}
+	else
+	{
+		stats->nuls++;
+	}
+	if (toursMaxPartie > 0 && partie->tour >= toursMaxPartie)
+	{
+		stats->abandons++;
+	}
+	for (int i = 0 ; i < partie->nbSerpents ; i++)
+	{
+		stats->deplacements[i] += partie->deplacements[i];
+		stats->pommes[i] += partie->nbPommes[i];
+		stats->causes[i][partie->causes[i]]++;
+	}
+}
 
-	// afficher les performances du programme
-	printf("Serpent 1 : %d déplacements et %d pommes mangées\n", deplacements1, nbPommes1);
-	printf("Serpent 2 : %d déplacements et %d pommes mangées\n", deplacements2, nbPommes2);
+void cumulerStatistiques(tStatistiques *total, tStatistiques *stats)
+{
+	total->nuls += stats->nuls;
+	total->abandons += stats->abandons;
+	for (int i = 0 ; i < NB_SERPENTS_MAX ; i++)
+	{
+		total->victoires[i] += stats->victoires[i];
+		total->deplacements[i] += stats->deplacements[i];
+		total->pommes[i] += stats->pommes[i];
+		for (int j = 0 ; j < NB_CAUSES ; j++)
+		{
+			total->causes[i][j] += stats->causes[i][j];
+		}
+	}
+}
 
-	return EXIT_SUCCESS;
+void afficherStatistiques(tStatistiques *total, long nbParties, int nbThreads, unsigned int graine, double duree)
+{
+	double n = (double)nbParties;
+	printf("Tournoi : %ld parties à %d serpents sur %d threads (graine %u) en %.3f secondes, %.0f parties/s\n",
+		nbParties, nbSerpentsPartie, nbThreads, graine, duree, n / duree);
+	for (int i = 0 ; i < nbSerpentsPartie ; i++)
+	{
+		printf("Victoires serpent %d : %ld (%.1f %%)\n", i + 1, total->victoires[i], 100.0 * (double)total->victoires[i] / n);
+	}
+	printf("Matchs nuls         : %ld (%.1f %%)\n", total->nuls, 100.0 * (double)total->nuls / n);
+	printf("Parties arrêtées après %ld déplacements : %ld\n", toursMaxPartie, total->abandons);
+	for (int i = 0 ; i < nbSerpentsPartie ; i++)
+	{
+		printf("Serpent %d : %.1f déplacements et %.2f pommes en moyenne\n",
+			i + 1, (double)total->deplacements[i] / n, (double)total->pommes[i] / n);
+	}
+	for (int i = 0 ; i < nbSerpentsPartie ; i++)
+	{
+		printf("Collisions serpent %d : %ld bordure/pavé, %ld lui-même, %ld adversaire\n",
+			i + 1, total->causes[i][CAUSE_BORDURE], total->causes[i][CAUSE_LUI_MEME], total->causes[i][CAUSE_ADVERSAIRE]);
+	}
 }
 
 /************************************************
@@ -364,7 +1845,7 @@ int main()
 
 
 *************************************************/
-void initPlateau(tPlateau plateau, int lesX[], int lesY[])
+void initPlateau(tPlateau plateau, int lesPavesX[], int lesPavesY[])
 {
 	// initialisation du plateau avec des espaces
 	for (int i = 1 ; i <= LARGEUR_PLATEAU ; i++)
@@ -396,10 +1877,10 @@ void initPlateau(tPlateau plateau, int lesX[], int lesY[])
 		plateau[LARGEUR_PLATEAU / 2][HAUTEUR_PLATEAU] = VIDE; // trou du bas
 	}
 	//  place les pavés sur le plateau
-    placerPaves(plateau);
+    placerPaves(plateau, lesPavesX, lesPavesY);
 }
 
-void placerPaves(tPlateau plateau)
+void placerPaves(tPlateau plateau, int lesPavesX[], int lesPavesY[])
 {
     // double boucle permettant d'afficher les pavés sous forme de carrés 
     for (int i = 0; i < NB_PAVES; i++)
@@ -431,117 +1912,834 @@ void dessinerPlateau(tPlateau plateau)
 	}
 }
 
-void ajouterPomme(tPlateau plateau, int iPomme)
+void ajouterPomme(tPartie *partie)
 {
 	/*
-    * génère aléatoirement la position d'une pomme,
-	* vérifie que ça correspond à une case vide
-	* du plateau puis l'ajoute au plateau et l'affiche 
+    * récupère la position de la pomme suivante (donnée en constante, ou tirée
+	* au hasard en mode tournoi jusqu'à tomber sur une case vide du plateau)
+	* puis l'ajoute au plateau. Si la position donnée en constante
+	* est occupée (serpent qui a grandi), la pomme est aussi tirée au hasard
     */
+	int iPomme = partie->nbPommesMangees;
 	int xPomme, yPomme;
+	bool premierEssai = true;
+	noter(partie, &partie->graine, sizeof(partie->graine));
+	noter(partie, &partie->lesPommesX[iPomme], sizeof(int));
+	noter(partie, &partie->lesPommesY[iPomme], sizeof(int));
 	do
 	{
-		xPomme = lesPommesX[iPomme];
-		yPomme = lesPommesY[iPomme];
-	} while (plateau[xPomme][yPomme] != ' ');
-	plateau[xPomme][yPomme] = POMME;
-	afficher(xPomme, yPomme, POMME);
+		if (partie->pommesAleatoires || !premierEssai)
+		{
+			partie->lesPommesX[iPomme] = 2 + rand_r(&partie->graine) % (LARGEUR_PLATEAU - 2);
+			partie->lesPommesY[iPomme] = 2 + rand_r(&partie->graine) % (HAUTEUR_PLATEAU - 2);
+		}
+		else
+		{
+			partie->lesPommesX[iPomme] = lesPommesX[iPomme];
+			partie->lesPommesY[iPomme] = lesPommesY[iPomme];
+		}
+		xPomme = partie->lesPommesX[iPomme];
+		yPomme = partie->lesPommesY[iPomme];
+		premierEssai = false;
+	} while (!caseLibre(partie, xPomme, yPomme));
+	noter(partie, &partie->plateau[xPomme][yPomme], 1);
+	noterBit(partie, partie->pommes, xPomme, yPomme);
+	partie->plateau[xPomme][yPomme] = POMME;
+	poserBit(partie->pommes, xPomme, yPomme);
+	noter(partie, partie->distancePomme, sizeof(partie->distancePomme));
+	calculerDistancesPomme(partie, xPomme, yPomme);
 }
 
 void afficher(int x, int y, char car)
 {
-    // se déplace aux coordonnées données en paramètres, affiche le caractère et revient en x=1 y=1
-	gotoxy(x, y);
-	printf("%c", car);
-	gotoxy(1, 1);
+	// rien n'est dessiné en mode sans affichage
+	if (sansAffichage)
+	{
+		return;
+	}
+    // place le caractère aux coordonnées données dans l'image du prochain rafraîchissement
+	ecranCible[x][y] = car;
+}
+
+void initEcran()
+{
+	// le terminal vient d'être effacé : les deux images ne contiennent que des cases vides
+	for (int i = 1 ; i <= LARGEUR_PLATEAU ; i++)
+	{
+		for (int j = 1 ; j <= HAUTEUR_PLATEAU ; j++)
+		{
+			ecranAffiche[i][j] = VIDE;
+			ecranCible[i][j] = VIDE;
+		}
+	}
+}
+
+void rafraichirEcran()
+{
+	/*
+	* compare l'image à afficher avec celle affichée, ligne par ligne, et regroupe
+	* dans un seul tampon le caractère de chaque case modifiée, précédé d'un
+	* déplacement du curseur seulement s'il n'est pas déjà sur cette case.
+	* Le tampon est envoyé au terminal en un seul appel à write (repris s'il est
+	* interrompu ou incomplet), et l'image affichée n'est mise à jour qu'une fois le
+	* tampon entièrement écrit : après un échec, les cases sont renvoyées au rafraîchissement suivant
+	*/
+	static char tampon[TAILLE_TAMPON_ECRAN];
+	int n = 0;
+	// position du curseur dans le terminal (0 : inconnue)
+	int curseurX = 0, curseurY = 0;
+
+	for (int j = 1 ; j <= HAUTEUR_PLATEAU ; j++)
+	{
+		for (int i = 1 ; i <= LARGEUR_PLATEAU ; i++)
+		{
+			if (ecranCible[i][j] != ecranAffiche[i][j])
+			{
+				if (curseurX != i || curseurY != j)
+				{
+					tampon[n++] = '\033';
+					tampon[n++] = '[';
+					n = ajouterNombre(tampon, n, j);
+					tampon[n++] = ';';
+					n = ajouterNombre(tampon, n, i);
+					tampon[n++] = 'H';
+				}
+				tampon[n++] = ecranCible[i][j];
+				curseurX = i + 1;
+				curseurY = j;
+			}
+		}
+	}
+	if (n == 0)
+	{
+		return;
+	}
+	// replace le curseur en x=1 y=1 comme après chaque affichage
+	memcpy(tampon + n, "\033[1;1H", 6);
+	n += 6;
+
+	// les printf en attente doivent arriver avant l'image
+	fflush(stdout);
+	int ecrit = 0;
+	while (ecrit < n)
+	{
+		ssize_t resultat = write(STDOUT_FILENO, tampon + ecrit, (size_t)(n - ecrit));
+		if (resultat < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (resultat <= 0)
+		{
+			return;
+		}
+		ecrit += (int)resultat;
+	}
+	memcpy(ecranAffiche, ecranCible, sizeof(tPlateau));
+}
+
+int ajouterNombre(char tampon[], int n, int nombre)
+{
+	// écrit l'entier positif nombre en décimal à partir de tampon[n] et retourne la nouvelle fin
+	char chiffres[12];
+	int nbChiffres = 0;
+	do
+	{
+		chiffres[nbChiffres++] = (char)('0' + nombre % 10);
+		nombre /= 10;
+	} while (nombre > 0);
+	while (nbChiffres > 0)
+	{
+		tampon[n++] = chiffres[--nbChiffres];
+	}
+	return n;
+}
+
+/************************************************
+	   FONCTIONS DU CORPS DES SERPENTS
+*************************************************/
+int anneauX(tCorps *corps, int i)
+{
+	// abscisse de l'anneau i (0 pour la tête)
+	return corps->lesX[(corps->tete - i) & MASQUE_ANNEAUX];
+}
+
+int anneauY(tCorps *corps, int i)
+{
+	// ordonnée de l'anneau i (0 pour la tête)
+	return corps->lesY[(corps->tete - i) & MASQUE_ANNEAUX];
+}
+
+void avancerCorps(tCorps *corps, int x, int y)
+{
+	// écrit la nouvelle tête dans la case suivante du tampon : l'ancienne queue
+	// sort du serpent sans rien déplacer, sauf si le serpent doit encore grandir
+	if (corps->aGrandir > 0 && corps->longueur < TAILLE_MAX)
+	{
+		corps->longueur++;
+		corps->aGrandir--;
+	}
+	else
+	{
+		libererCase(corps, anneauX(corps, corps->longueur - 1), anneauY(corps, corps->longueur - 1));
+	}
+	corps->tete = (corps->tete + 1) & MASQUE_ANNEAUX;
+	corps->lesX[corps->tete] = x;
+	corps->lesY[corps->tete] = y;
+	occuperCase(corps, x, y);
+}
+
+bool caseOccupee(tCorps *corps, int x, int y)
+{
+	// test d'un seul bit, quelle que soit la longueur du serpent
+	return lireBit(corps->occupation, x, y);
+}
+
+void occuperCase(tCorps *corps, int x, int y)
+{
+	poserBit(corps->occupation, x, y);
+}
+
+void libererCase(tCorps *corps, int x, int y)
+{
+	oterBit(corps->occupation, x, y);
+}
+
+/************************************************
+	   FONCTIONS DES PLANS DE BITS
+*************************************************/
+bool lireBit(tPlan plan, int x, int y)
+{
+	return (plan[y][x / 64] >> (x % 64)) & 1;
+}
+
+void poserBit(tPlan plan, int x, int y)
+{
+	plan[y][x / 64] |= (uint64_t)1 << (x % 64);
+}
+
+void oterBit(tPlan plan, int x, int y)
+{
+	plan[y][x / 64] &= ~((uint64_t)1 << (x % 64));
+}
+
+bool caseLibre(tPartie *partie, int x, int y)
+{
+	// ni mur, ni serpent, ni pomme : un mot de chaque plan
+	int w = x / 64;
+	return (((partie->murs[y][w] | partie->serpents[y][w] | partie->pommes[y][w]) >> (x % 64)) & 1) == 0;
+}
+
+void initMurs(tPartie *partie)
+{
+	// toutes les cases sont des murs, sauf les cases du plateau qui ne sont pas des bordures :
+	// les bits hors du plateau (ligne 0, colonne 0, fin du dernier mot) ne sont jamais libres
+	memset(partie->murs, 0xff, sizeof(partie->murs));
+	for (int y = 1 ; y <= HAUTEUR_PLATEAU ; y++)
+	{
+		for (int x = 1 ; x <= LARGEUR_PLATEAU ; x++)
+		{
+			if (partie->plateau[x][y] != BORDURE)
+			{
+				oterBit(partie->murs, x, y);
+			}
+		}
+	}
+}
+
+void dilaterPlan(tPlan source, tPlan resultat, int premiere, int derniere)
+{
+	/*
+	* place dans les lignes premiere à derniere de resultat les cases voisines (haut, bas,
+	* gauche, droite) des cases de source, issues comprises comme dans caseVoisine. Chaque
+	* ligne est traitée mot par mot : les voisines de gauche et de droite sont la ligne
+	* décalée d'un bit, les voisines du haut et du bas sont les lignes au-dessus et en dessous
+	*/
+	for (int y = premiere ; y <= derniere ; y++)
+	{
+		// lignes voisines, la première et la dernière ligne communiquant par les issues
+		int dessus = (y == 1) ? HAUTEUR_PLATEAU : y - 1;
+		int dessous = (y == HAUTEUR_PLATEAU) ? 1 : y + 1;
+		for (int w = 0 ; w < MOTS_PAR_LIGNE ; w++)
+		{
+			uint64_t gauche = source[y][w] << 1;
+			uint64_t droite = source[y][w] >> 1;
+			if (w > 0)
+			{
+				gauche |= source[y][w - 1] >> 63;
+			}
+			if (w + 1 < MOTS_PAR_LIGNE)
+			{
+				droite |= source[y][w + 1] << 63;
+			}
+			resultat[y][w] = gauche | droite | source[dessus][w] | source[dessous][w];
+		}
+		// la première et la dernière colonne communiquent par les issues
+		if (lireBit(source, 1, y))
+		{
+			poserBit(resultat, LARGEUR_PLATEAU, y);
+		}
+		if (lireBit(source, LARGEUR_PLATEAU, y))
+		{
+			poserBit(resultat, 1, y);
+		}
+	}
+}
+
+int espaceLibre(tPartie *partie, int x, int y, int limite)
+{
+	/*
+	* remplissage par diffusion depuis (x, y) sur les cases libres (ni mur, ni serpent) :
+	* à chaque étape toutes les cases atteintes s'étendent d'une case en une dilatation
+	* du plan, limitée aux lignes que le remplissage a pu atteindre. Retourne le nombre
+	* de cases atteintes, (x, y) comprise, en s'arrêtant dès que ce nombre atteint limite
+	*/
+	uint64_t (*atteint)[MOTS_PAR_LIGNE] = partie->parcours->atteint;
+	uint64_t (*voisins)[MOTS_PAR_LIGNE] = partie->parcours->voisins;
+	int nbCases = 1;
+	int premiere = y, derniere = y;
+	bool nouvelles = true;
+
+	memset(atteint, 0, sizeof(tPlan));
+	poserBit(atteint, x, y);
+	while (nouvelles && nbCases < limite)
+	{
+		// le remplissage gagne au plus une ligne de chaque côté, toutes s'il passe par une issue
+		premiere = (premiere <= 2 || derniere >= HAUTEUR_PLATEAU - 1) ? 1 : premiere - 1;
+		derniere = (premiere == 1) ? HAUTEUR_PLATEAU : derniere + 1;
+		dilaterPlan(atteint, voisins, premiere, derniere);
+		nouvelles = false;
+		for (int j = premiere ; j <= derniere ; j++)
+		{
+			for (int w = 0 ; w < MOTS_PAR_LIGNE ; w++)
+			{
+				uint64_t ajout = voisins[j][w] & ~partie->murs[j][w] & ~partie->serpents[j][w] & ~atteint[j][w];
+				atteint[j][w] |= ajout;
+				// peu de cases s'ajoutent à chaque étape : un tour de boucle par bit à 1
+				while (ajout != 0)
+				{
+					nbCases++;
+					nouvelles = true;
+					ajout &= ajout - 1;
+				}
+			}
+		}
+	}
+	return nbCases;
+}
+
+/************************************************
+	   FONCTIONS DE RECHERCHE DU PLUS COURT CHEMIN
+*************************************************/
+bool directionPlusCourtChemin(tPartie *partie, int iSerpent, int objectifX, int objectifY, char *direction)
+{
+	/*
+	* parcours en largeur du plateau depuis la tête du serpent jusqu'à l'objectif,
+	* en passant par les issues. Une case d'un corps n'est franchissable qu'à partir
+	* du déplacement où elle aura été libérée par la queue qui avance. Le coût est
+	* borné par le nombre de cases du plateau. Retourne false s'il n'existe pas de
+	* chemin, sinon place dans direction le premier déplacement du chemin
+	*/
+	static const char lesDirections[4] = {HAUT, BAS, GAUCHE, DROITE};
+	tParcours *parcours = partie->parcours;
+	// nombre de déplacements à attendre avant que chaque case soit libre
+	int (*liberation)[HAUTEUR_PLATEAU + 1] = parcours->liberation;
+	// nombre de déplacements pour atteindre chaque case (-1 : pas encore atteinte)
+	int (*distance)[HAUTEUR_PLATEAU + 1] = parcours->distance;
+	// premier déplacement du chemin menant à chaque case
+	char (*premiere)[HAUTEUR_PLATEAU + 1] = parcours->premiere;
+	int *fileX = parcours->fileX, *fileY = parcours->fileY;
+	int debutFile = 0, finFile = 0;
+	int xTete = partie->tetesX[iSerpent];
+	int yTete = partie->tetesY[iSerpent];
+
+	memset(liberation, 0, sizeof(parcours->liberation));
+	memset(distance, -1, sizeof(parcours->distance));
+
+	// l'anneau i d'un serpent quitte sa case après longueur - i déplacements (plus la croissance
+	// restante). Les autres serpents jouent en même temps : un déplacement de plus par prudence
+	for (int s = 0 ; s < partie->nbSerpents ; s++)
+	{
+		if (!partie->vivants[s])
+		{
+			continue;
+		}
+		tCorps *corps = &partie->corps[s];
+		int prudence = (s == iSerpent) ? 0 : 1;
+		for (int i = 0 ; i < corps->longueur ; i++)
+		{
+			liberation[anneauX(corps, i)][anneauY(corps, i)] = corps->longueur - i + corps->aGrandir + prudence;
+		}
+	}
+	// les cases voisines de la tête des serpents prioritaires (voir caseVisee)
+	// sont interdites au premier déplacement
+	for (int s = 0 ; s < iSerpent ; s++)
+	{
+		if (!partie->vivants[s])
+		{
+			continue;
+		}
+		for (int d = 0 ; d < 4 ; d++)
+		{
+			int voisinX, voisinY;
+			caseVoisine(partie->tetesX[s], partie->tetesY[s], lesDirections[d], &voisinX, &voisinY);
+			if (liberation[voisinX][voisinY] < 2)
+			{
+				liberation[voisinX][voisinY] = 2;
+			}
+		}
+	}
+
+	distance[xTete][yTete] = 0;
+	fileX[finFile] = xTete;
+	fileY[finFile] = yTete;
+	finFile++;
+	while (debutFile < finFile)
+	{
+		int x = fileX[debutFile];
+		int y = fileY[debutFile];
+		debutFile++;
+		if (x == objectifX && y == objectifY && distance[x][y] > 0)
+		{
+			*direction = premiere[x][y];
+			return true;
+		}
+		for (int d = 0 ; d < 4 ; d++)
+		{
+			int voisinX, voisinY;
+			caseVoisine(x, y, lesDirections[d], &voisinX, &voisinY);
+			if (distance[voisinX][voisinY] == -1 && !lireBit(partie->murs, voisinX, voisinY)
+				&& liberation[voisinX][voisinY] <= distance[x][y] + 1)
+			{
+				distance[voisinX][voisinY] = distance[x][y] + 1;
+				premiere[voisinX][voisinY] = (distance[x][y] == 0) ? lesDirections[d] : premiere[x][y];
+				fileX[finFile] = voisinX;
+				fileY[finFile] = voisinY;
+				finFile++;
+			}
+		}
+	}
+	return false;
+}
+
+void calculerDistancesPomme(tPartie *partie, int xPomme, int yPomme)
+{
+	/*
+	* parcours en largeur depuis la pomme sur le plateau sans les serpents (bordures,
+	* pavés et issues ne changent pas pendant la partie). Les déplacements étant
+	* réversibles, même par les issues, distancePomme donne pour chaque case le
+	* nombre de déplacements jusqu'à la pomme. Chaque niveau du parcours est obtenu
+	* d'un coup en dilatant le plan du niveau précédent, privé des murs et des
+	* cases déjà atteintes
+	*/
+	uint64_t (*atteint)[MOTS_PAR_LIGNE] = partie->parcours->atteint;
+	uint64_t (*niveau)[MOTS_PAR_LIGNE] = partie->parcours->niveau;
+	uint64_t (*voisins)[MOTS_PAR_LIGNE] = partie->parcours->voisins;
+	int distance = 0;
+	bool nonVide = true;
+
+	memset(partie->distancePomme, -1, sizeof(partie->distancePomme));
+	memset(atteint, 0, sizeof(tPlan));
+	memset(niveau, 0, sizeof(tPlan));
+	poserBit(atteint, xPomme, yPomme);
+	poserBit(niveau, xPomme, yPomme);
+	while (nonVide)
+	{
+		// distance de chaque case du niveau : une case par bit à 1
+		for (int y = 1 ; y <= HAUTEUR_PLATEAU ; y++)
+		{
+			for (int w = 0 ; w < MOTS_PAR_LIGNE ; w++)
+			{
+				uint64_t bits = niveau[y][w];
+				while (bits != 0)
+				{
+					partie->distancePomme[w * 64 + __builtin_ctzll(bits)][y] = distance;
+					bits &= bits - 1;
+				}
+			}
+		}
+		// niveau suivant
+		dilaterPlan(niveau, voisins, 1, HAUTEUR_PLATEAU);
+		nonVide = false;
+		for (int y = 1 ; y <= HAUTEUR_PLATEAU ; y++)
+		{
+			for (int w = 0 ; w < MOTS_PAR_LIGNE ; w++)
+			{
+				niveau[y][w] = voisins[y][w] & ~partie->murs[y][w] & ~atteint[y][w];
+				atteint[y][w] |= niveau[y][w];
+				nonVide |= (niveau[y][w] != 0);
+			}
+		}
+		distance++;
+	}
+}
+
+bool directionDistancesPomme(tPartie *partie, int iSerpent, char *direction)
+{
+	/*
+	* choisit parmi les 4 cases voisines de la tête celle qui est la plus proche de la pomme.
+	* Retourne false si la pomme est inaccessible ou si toutes les cases voisines les plus
+	* proches sont bloquées par un corps, peuvent être atteintes par un serpent prioritaire,
+	* ou mènent à un espace libre plus petit que le serpent : il faut alors chercher
+	* un chemin en tenant compte des serpents
+	*/
+	static const char lesDirections[4] = {HAUT, BAS, GAUCHE, DROITE};
+	tCorps *corps = &partie->corps[iSerpent];
+	int meilleure = -1;
+	bool trouve = false;
+
+	for (int d = 0 ; d < 4 ; d++)
+	{
+		int voisinX, voisinY;
+		caseVoisine(partie->tetesX[iSerpent], partie->tetesY[iSerpent], lesDirections[d], &voisinX, &voisinY);
+		int distance = partie->distancePomme[voisinX][voisinY];
+		if (distance == -1 || (meilleure != -1 && distance > meilleure))
+		{
+			continue;
+		}
+		// la queue du serpent libère sa case pendant ce déplacement (sauf s'il grandit)
+		bool queue = corps->aGrandir == 0 && voisinX == anneauX(corps, corps->longueur - 1)
+			&& voisinY == anneauY(corps, corps->longueur - 1);
+		bool libre = (queue || !lireBit(partie->serpents, voisinX, voisinY))
+			&& !caseVisee(partie, iSerpent, voisinX, voisinY)
+			&& espaceLibre(partie, voisinX, voisinY, corps->longueur) >= corps->longueur;
+		if (meilleure == -1 || distance < meilleure)
+		{
+			meilleure = distance;
+			trouve = false;
+		}
+		if (libre && !trouve)
+		{
+			*direction = lesDirections[d];
+			trouve = true;
+		}
+	}
+	return trouve;
+}
+
+void caseVoisine(int x, int y, char direction, int *voisinX, int *voisinY)
+{
+	// case atteinte depuis (x, y) dans la direction donnée, issues comprises
+	switch (direction)
+	{
+		case HAUT:
+			y--;
+			break;
+		case BAS:
+			y++;
+			break;
+		case GAUCHE:
+			x--;
+			break;
+		case DROITE:
+			x++;
+			break;
+	}
+	if (x <= 0)
+	{
+		x = LARGEUR_PLATEAU;
+	}
+	else if (x > LARGEUR_PLATEAU)
+	{
+		x = 1;
+	}
+	else if (y <= 0)
+	{
+		y = HAUTEUR_PLATEAU;
+	}
+	else if (y > HAUTEUR_PLATEAU)
+	{
+		y = 1;
+	}
+	*voisinX = x;
+	*voisinY = y;
+}
+
+/************************************************
+	   FONCTIONS ET PROCEDURES DES SERPENTS
+*************************************************/
+char strategieChemin(tPartie *partie, int iSerpent)
+{
+	/*
+	* case voisine la plus proche de la pomme d'après les distances calculées à son
+	* apparition, plus court chemin recalculé si un corps bloque cette case, ou
+	* stratégie gloutonne s'il n'existe pas de chemin libre
+	*/
+	char direction;
+	int xPomme = partie->lesPommesX[partie->nbPommesMangees];
+	int yPomme = partie->lesPommesY[partie->nbPommesMangees];
+
+	if (directionDistancesPomme(partie, iSerpent, &direction)
+		|| directionPlusCourtChemin(partie, iSerpent, xPomme, yPomme, &direction))
+	{
+		return direction;
+	}
+	return strategieGloutonneHorizontale(partie, iSerpent);
+}
+
+char strategieGloutonneVerticale(tPartie *partie, int iSerpent)
+{
+	// stratégie d'origine du serpent 1 : vers l'objectif, verticalement d'abord
+	int objectifX, objectifY;
+	objectifGlouton(partie, iSerpent, &objectifX, &objectifY);
+	return directionVerticaleDAbord(partie, iSerpent, objectifX, objectifY);
+}
+
+char strategieGloutonneHorizontale(tPartie *partie, int iSerpent)
+{
+	// stratégie d'origine du serpent 2 : vers l'objectif, horizontalement d'abord
+	int objectifX, objectifY;
+	objectifGlouton(partie, iSerpent, &objectifX, &objectifY);
+	return directionHorizontaleDAbord(partie, iSerpent, objectifX, objectifY);
+}
+
+char strategiePrevoyante(tPartie *partie, int iSerpent)
+{
+	/*
+	* joue chaque direction avec le journal de recherche de la partie puis l'annule :
+	* la direction qui survit le plus de tours sur PROFONDEUR_RECHERCHE, à égalité celle
+	* qui mène à un espace libre d'au moins la longueur du serpent (la recherche est trop
+	* courte pour voir qu'il s'enferme), puis celle dont la case voisine est la plus
+	* proche de la pomme. La partie ressort inchangée
+	*/
+	int longueur = partie->corps[iSerpent].longueur;
+	char meilleure = partie->directions[iSerpent];
+	int meilleureSurvie = -1;
+	int meilleurEspace = 0;
+	int meilleureDistance = 0;
+
+	if (partie->journalRecherche == NULL)
+	{
+		partie->journalRecherche = creerJournal();
+	}
+	partie->journal = partie->journalRecherche;
+	for (char direction = HAUT ; direction <= DROITE ; direction++)
+	{
+		int survie = explorerDirection(partie, iSerpent, direction, PROFONDEUR_RECHERCHE);
+		int x, y, distance, espace;
+		caseVoisine(partie->tetesX[iSerpent], partie->tetesY[iSerpent], direction, &x, &y);
+		distance = partie->distancePomme[x][y];
+		if (distance < 0)
+		{
+			distance = NB_CASES;
+		}
+		espace = (survie > 0 && espaceLibre(partie, x, y, longueur) >= longueur) ? 1 : 0;
+		if (survie > meilleureSurvie || (survie == meilleureSurvie && (espace > meilleurEspace
+			|| (espace == meilleurEspace && distance < meilleureDistance))))
+		{
+			meilleure = direction;
+			meilleureSurvie = survie;
+			meilleurEspace = espace;
+			meilleureDistance = distance;
+		}
+	}
+	partie->journal = NULL;
+	return meilleure;
 }
 
-void effacer(int x, int y)
+int explorerDirection(tPartie *partie, int iSerpent, char direction, int profondeur)
 {
-    // se déplace aux coordonnées données en paramètres, "efface" le caractère et revient en x=1 y=1
-	gotoxy(x, y);
-	printf("%c", VIDE);
-	gotoxy(1, 1);
+	/*
+	* joue un tour où le serpent iSerpent prend la direction donnée, sans entrer sur une case
+	* que la tête d'un autre serpent peut atteindre (caseRivale), et où les autres gardent
+	* leur direction s'ils le peuvent (directionRivale), explore les tours suivants jusqu'à profondeur tours, puis annule le tour.
+	* Retourne le nombre de tours survécus de la meilleure suite (profondeur si la partie
+	* se termine avec le serpent en jeu)
+	*/
+	char choix[NB_SERPENTS_MAX];
+	long marque;
+	int survie = 0;
+	int x, y;
+
+	// les autres serpents ne gardent pas forcément leur direction : une case que la tête
+	// d'un autre serpent peut atteindre au même tour compte comme une collision
+	caseVoisine(partie->tetesX[iSerpent], partie->tetesY[iSerpent], direction, &x, &y);
+	if (caseRivale(partie, iSerpent, x, y))
+	{
+		return 0;
+	}
+	for (int i = 0 ; i < partie->nbSerpents ; i++)
+	{
+		choix[i] = partie->vivants[i] ? directionRivale(partie, i) : partie->directions[i];
+	}
+	choix[iSerpent] = direction;
+	marque = jouerCoup(partie, choix);
+	// la fin de la partie par l'élimination des autres serpents n'arrête pas la recherche :
+	// le serpent doit encore survivre aux tours suivants
+	if (partie->vivants[iSerpent])
+	{
+		if (profondeur == 1 || partie->gagne)
+		{
+			survie = profondeur;
+		}
+		else
+		{
+			// une suite qui survit jusqu'au bout ne peut pas être battue
+			for (char suivante = HAUT ; suivante <= DROITE && survie < profondeur ; suivante++)
+			{
+				int survieSuivante = 1 + explorerDirection(partie, iSerpent, suivante, profondeur - 1);
+				if (survieSuivante > survie)
+				{
+					survie = survieSuivante;
+				}
+			}
+		}
+	}
+	annulerCoup(partie, marque);
+	return survie;
 }
 
-/************************************************
-	   FONCTIONS ET PROCEDURES DU SERPENT 1	    
-*************************************************/
-void dessinerSerpent1(int lesX1[], int lesY1[])
+void objectifGlouton(tPartie *partie, int iSerpent, int *objectifX, int *objectifY)
 {
-	int i;
-	// affiche les anneaux puis la tête
-	for(i = 1 ; i < TAILLE ; i++)
+	// se diriger vers l'issue du meilleur chemin estimé par calculDistance,
+	// puis vers la pomme une fois l'issue empruntée
+	*objectifX = partie->lesPommesX[partie->nbPommesMangees];
+	*objectifY = partie->lesPommesY[partie->nbPommesMangees];
+	if (partie->utiliserIssues[iSerpent])
+	{
+		return;
+	}
+	switch (partie->meilleuresDistances[iSerpent])
 	{
-		afficher(lesX1[i], lesY1[i], CORPS);
+		case HAUT: // se dirige vers le trou du haut
+			*objectifX = ISSUE_HAUT_X;
+			*objectifY = ISSUE_HAUT_Y;
+			break;
+		case BAS: // se dirige vers le trou du bas
+			*objectifX = ISSUE_BAS_X;
+			*objectifY = ISSUE_BAS_Y;
+			break;
+		case GAUCHE: // se dirige vers le trou de gauche
+			*objectifX = ISSUE_GAUCHE_X;
+			*objectifY = ISSUE_GAUCHE_Y;
+			break;
+		case DROITE: // se dirige vers le trou de droite
+			*objectifX = ISSUE_DROITE_X;
+			*objectifY = ISSUE_DROITE_Y;
+			break;
 	}
-	afficher(lesX1[0], lesY1[0], TETE_SERPENT_1);
 }
 
-void directionSerpent1(int lesX1[], int lesY1[], tPlateau plateau, char *direction1, int x, int y, int lesX2[], int lesY2[], char directionSerpent2)
+char directionVerticaleDAbord(tPartie *partie, int iSerpent, int x, int y)
 {
 	// Calcul des directions possibles
-	int differenceX = x - lesX1[0]; // Différence en X
-	int differenceY = y - lesY1[0]; // Différence en Y
+	int differenceX = x - partie->tetesX[iSerpent]; // Différence en X
+	int differenceY = y - partie->tetesY[iSerpent]; // Différence en Y
+	char direction = partie->directions[iSerpent];
 
 	// Essayer de se déplacer dans la direction verticale
 	if (differenceY != 0)
 	{
-		*direction1 = (differenceY > 0) ? BAS : HAUT;
-		if (verifierCollisionProchainDeplacement1(lesX1, lesY1, plateau, *direction1, lesX2, lesY2, directionSerpent2))
+		direction = (differenceY > 0) ? BAS : HAUT;
+		if (verifierCollisionProchainDeplacement(partie, iSerpent, direction))
 		{
 			// Si collision, essayer la direction horizontale
-			*direction1 = (differenceX > 0) ? DROITE : GAUCHE;
-			if (verifierCollisionProchainDeplacement1(lesX1, lesY1, plateau, *direction1, lesX2, lesY2, directionSerpent2))
+			direction = (differenceX > 0) ? DROITE : GAUCHE;
+			if (verifierCollisionProchainDeplacement(partie, iSerpent, direction))
 			{
 				// Si collision, essayer l'autre direction horizontale
-				*direction1 = (differenceX > 0) ? GAUCHE : DROITE;
-				if (verifierCollisionProchainDeplacement1(lesX1, lesY1, plateau, *direction1, lesX2, lesY2, directionSerpent2))
+				direction = (differenceX > 0) ? GAUCHE : DROITE;
+				if (verifierCollisionProchainDeplacement(partie, iSerpent, direction))
 				{
 					// Si collision, essayer l'autre direction verticale
-					*direction1 = (differenceY > 0) ? HAUT : BAS;
+					direction = (differenceY > 0) ? HAUT : BAS;
 				}
 			}
 		}
 	}
-	
+
 	// Si pas de déplacement horizontal possible, essayer horizontal
 	else if (differenceX != 0)
 	{
-		*direction1 = (differenceX > 0) ? DROITE : GAUCHE;
-		if (verifierCollisionProchainDeplacement1(lesX1, lesY1, plateau, *direction1, lesX2, lesY2, directionSerpent2))
+		direction = (differenceX > 0) ? DROITE : GAUCHE;
+		if (verifierCollisionProchainDeplacement(partie, iSerpent, direction))
 		{
 			// Si collision, essayer la direction verticale
-			*direction1 = (differenceY > 0) ? BAS : HAUT;
-			if (verifierCollisionProchainDeplacement1(lesX1, lesY1, plateau, *direction1, lesX2, lesY2, directionSerpent2))
+			direction = (differenceY > 0) ? BAS : HAUT;
+			if (verifierCollisionProchainDeplacement(partie, iSerpent, direction))
 			{
 				// Si collision, essayer l'autre direction verticale
-				*direction1 = (differenceY > 0) ? HAUT : BAS;
-				if (verifierCollisionProchainDeplacement1(lesX1, lesY1, plateau, *direction1, lesX2, lesY2, directionSerpent2))
+				direction = (differenceY > 0) ? HAUT : BAS;
+				if (verifierCollisionProchainDeplacement(partie, iSerpent, direction))
 				{
 					// Si collision, essayer l'autre direction horizontale
-					*direction1 = (differenceX > 0) ? GAUCHE : DROITE;
+					direction = (differenceX > 0) ? GAUCHE : DROITE;
 				}
 			}
 		}
 	}
+	return direction;
+}
+
+char directionHorizontaleDAbord(tPartie *partie, int iSerpent, int objectifX, int objectifY)
+{
+    // Calcul des directions possibles
+    int differenceX = objectifX - partie->tetesX[iSerpent]; // Différence en X
+    int differenceY = objectifY - partie->tetesY[iSerpent]; // Différence en Y
+
+    // Tableau pour stocker les directions possibles sans collision
+    char directionsValides[4] = {HAUT, BAS, GAUCHE, DROITE};
+    bool directionValide[4] = {true, true, true, true}; // indique si la direction est valide
+    int nbDirectionsValides = 4;
+
+    // Vérifier chaque direction possible
+    for(int i = 0; i < 4; i++)
+    {
+        if(verifierCollisionProchainDeplacement(partie, iSerpent, directionsValides[i])) {
+            directionValide[i] = false;
+            nbDirectionsValides--;
+        }
+    }
+
+    // Si aucune direction n'est valide, on garde la direction actuelle
+    if(nbDirectionsValides == 0)
+    {
+        return partie->directions[iSerpent];
+    }
+
+    // Priorité à la direction horizontale qui rapproche de l'objectif
+    if(differenceX > 0 && directionValide[3])
+    { // DROITE
+        return DROITE;
+    } else if(differenceX < 0 && directionValide[2])
+    { // GAUCHE
+        return GAUCHE;
+    }
+    // Si horizontal impossible, essayer vertical
+    else if(differenceY > 0 && directionValide[1])
+    { // BAS
+        return BAS;
+    } else if(differenceY < 0 && directionValide[0])
+    { // HAUT
+        return HAUT;
+    }
+    // Sinon prendre la première direction valide
+    for(int i = 0; i < 4; i++)
+    {
+        if(directionValide[i])
+        {
+            return directionsValides[i];
+        }
+    }
+    return partie->directions[iSerpent];
 }
 
-int calculDistance1(int lesX1[], int lesY1[], int pommeX, int pommeY)
+int calculDistance(tPartie *partie, int iSerpent, int pommeX, int pommeY)
 {
-    // définition des variables des chemins différents 
+    // définition des variables des chemins différents
     int passageIssueGauche, passageIssueDroit, passageIssueHaut, passageIssueBas, passageDirect;
+    int xTete = partie->tetesX[iSerpent];
+    int yTete = partie->tetesY[iSerpent];
 
     // Calcul des distancesen utilisant chaque issue et en allant directement par le plateau
-    passageIssueGauche = abs(lesX1[0] - ISSUE_GAUCHE_X) + abs(lesY1[0] - ISSUE_GAUCHE_Y) + 
+    passageIssueGauche = abs(xTete - ISSUE_GAUCHE_X) + abs(yTete - ISSUE_GAUCHE_Y) +
         abs(pommeX - ISSUE_DROITE_X) + abs(pommeY - ISSUE_DROITE_Y);
-    passageIssueDroit = abs(lesX1[0] - ISSUE_DROITE_X) + abs(lesY1[0] - ISSUE_DROITE_Y) + 
+    passageIssueDroit = abs(xTete - ISSUE_DROITE_X) + abs(yTete - ISSUE_DROITE_Y) +
         abs(pommeX - ISSUE_GAUCHE_X) + abs(pommeY - ISSUE_GAUCHE_Y);
-    passageIssueHaut = abs(lesX1[0] - ISSUE_HAUT_X) + abs(lesY1[0] - ISSUE_HAUT_Y) + 
+    passageIssueHaut = abs(xTete - ISSUE_HAUT_X) + abs(yTete - ISSUE_HAUT_Y) +
         abs(pommeX - ISSUE_BAS_X) + abs(pommeY - ISSUE_BAS_Y);
-    passageIssueBas = abs(lesX1[0] - ISSUE_BAS_X) + abs(lesY1[0] - ISSUE_BAS_Y) + 
+    passageIssueBas = abs(xTete - ISSUE_BAS_X) + abs(yTete - ISSUE_BAS_Y) +
         abs(pommeX - ISSUE_HAUT_X) + abs(pommeY - ISSUE_HAUT_Y);
-    passageDirect = abs(lesX1[0] - pommeX) + abs(lesY1[0] - pommeY);
+    passageDirect = abs(xTete - pommeX) + abs(yTete - pommeY);
 
     // compare les résultats pour obtenir le meilleur chemin
     // chemin direct vers la pomme sans passer dans un trou
@@ -569,472 +2767,274 @@ int calculDistance1(int lesX1[], int lesY1[], int pommeX, int pommeY)
     }
 }
 
-bool verifierCollisionProchainDeplacement1(int lesX1[], int lesY1[], tPlateau plateau, char prochaineDirection1, int lesX2[], int lesY2[], char directionSerpent2)
+bool verifierCollisionProchainDeplacement(tPartie *partie, int iSerpent, char prochaineDirection)
 {
-    int nouvelleX = lesX1[0];
-    int nouvelleY = lesY1[0];
+    int nouvelleX, nouvelleY;
 
-    // Calcul de la nouvelle position
-    switch (prochaineDirection1)
-    {
-        case HAUT:
-            nouvelleY--;
-            break;
-        case BAS:
-            nouvelleY++;
-            break;
-        case GAUCHE:
-            nouvelleX--;
-            break;
-        case DROITE:
-            nouvelleX++;
-            break;
-    }
+    // Calcul de la nouvelle position, issues comprises
+    caseVoisine(partie->tetesX[iSerpent], partie->tetesY[iSerpent], prochaineDirection, &nouvelleX, &nouvelleY);
 
     // Collision avec les bordures
-    if (plateau[nouvelleX][nouvelleY] == BORDURE)
+    if (lireBit(partie->murs, nouvelleX, nouvelleY))
     {
         return true;
     }
 
-    // Collision tête contre tête avec le serpent 2
-    if (nouvelleX == lesX2[0] && nouvelleY == lesY2[0])
+    // Collision avec le corps d'un serpent en jeu, le sien compris (un seul bit pour tous)
+    if (lireBit(partie->serpents, nouvelleX, nouvelleY))
     {
-        // Si les serpents sont à égale distance de la pomme, 
-        // le serpent 2 a la priorité (le serpent 1 doit éviter)
-        if (plateau[lesX2[0]][lesY2[0]] == POMME)
-        {
-            return true;
-        }
         return true;
     }
 
-    // Prédiction de la prochaine position du serpent 2
-    int prochaineX2 = lesX2[0];
-    int prochaineY2 = lesY2[0];
-    switch (directionSerpent2)
-    {
-        case HAUT:
-            prochaineY2--;
-            break;
-        case BAS:
-            prochaineY2++;
-            break;
-        case GAUCHE:
-            prochaineX2--;
-            break;
-        case DROITE:
-            prochaineX2++;
-            break;
-    }
-
-    // Si la nouvelle position va créer une collision, éviter
-    if (nouvelleX == prochaineX2 && nouvelleY == prochaineY2)
-    {
-        return true;
-    }
+    // Si un serpent prioritaire peut aussi atteindre la nouvelle position, éviter
+    return caseVisee(partie, iSerpent, nouvelleX, nouvelleY);
+}
 
-    // Collision avec le serpent 2 ou son propre corps
-    for (int i = 0; i < TAILLE; i++)
+bool caseVisee(tPartie *partie, int iSerpent, int x, int y)
+{
+    /*
+    * vrai si (x, y) est voisine de la tête d'un serpent en jeu de plus petit numéro :
+    * les serpents se déplaçant en même temps, une case que deux têtes peuvent atteindre
+    * est laissée au serpent de plus petit numéro, ce qui évite les collisions tête
+    * contre tête sans connaître à l'avance la direction choisie par les autres serpents
+    */
+    static const char lesDirections[4] = {HAUT, BAS, GAUCHE, DROITE};
+    for (int i = 0 ; i < iSerpent ; i++)
     {
-        if ((lesX1[i] == nouvelleX && lesY1[i] == nouvelleY) || 
-            (lesX2[i] == nouvelleX && lesY2[i] == nouvelleY))
+        if (!partie->vivants[i])
+        {
+            continue;
+        }
+        for (int d = 0 ; d < 4 ; d++)
         {
-            return true;
+            int voisinX, voisinY;
+            caseVoisine(partie->tetesX[i], partie->tetesY[i], lesDirections[d], &voisinX, &voisinY);
+            if (voisinX == x && voisinY == y)
+            {
+                return true;
+            }
         }
     }
-
     return false;
 }
 
-void progresser1(int lesX1[], int lesY1[], char direction1, tPlateau plateau, bool *collision1, bool *pommeMangee1, bool *utiliserIssue1)
-{
-    // ajout d'un déplacement pour le serpent 1
-    deplacements1++; 
-
-    // Effacer l'ancienne position du serpent dans le plateau
-    plateau[lesX1[TAILLE - 1]][lesY1[TAILLE - 1]] = VIDE;
-    for (int i = 0; i < TAILLE; i++)
-    {
-        plateau[lesX1[i]][lesY1[i]] = VIDE;
-    }
-    
-    // Effacer le dernier élément à l'écran
-    effacer(lesX1[TAILLE - 1], lesY1[TAILLE - 1]);
-
-    // Mettre à jour les positions
-    for (int i = TAILLE - 1; i > 0; i--)
-    {
-        lesX1[i] = lesX1[i - 1];
-        lesY1[i] = lesY1[i - 1];
-    }
-    
-    // Faire progresser la tête dans la nouvelle direction
-    switch (direction1)
-    {
-        case HAUT:
-            lesY1[0] = lesY1[0] - 1;
-            break;
-        case BAS:
-            lesY1[0] = lesY1[0] + 1;
-            break;
-        case DROITE:
-            lesX1[0] = lesX1[0] + 1;
-            break;
-        case GAUCHE:
-            lesX1[0] = lesX1[0] - 1;
-            break;
-    }
-
-    // Gestion des passages par les issues
-    if (lesX1[0] <= 0) //issue droite
-    {
-        lesX1[0] = LARGEUR_PLATEAU;
-        *utiliserIssue1 = true;
-    }
-    else if (lesX1[0] > LARGEUR_PLATEAU) // issue gauche
-    {
-        lesX1[0] = 1;
-        *utiliserIssue1 = true;
-    }
-    else if (lesY1[0] <= 0) // issue bas
-    {
-        lesY1[0] = HAUTEUR_PLATEAU;
-        *utiliserIssue1 = true;
-    }
-    else if (lesY1[0] > HAUTEUR_PLATEAU) // issue haut
-    {
-        lesY1[0] = 1;
-        *utiliserIssue1 = true;
-    }
-
-    *pommeMangee1 = false;
-    // Vérification des collisions et mise à jour du plateau
-    if (plateau[lesX1[0]][lesY1[0]] == POMME) // "collision" avec une pomme
-    {
-        *pommeMangee1 = true;
-        plateau[lesX1[0]][lesY1[0]] = VIDE;
-    }
-    else if (plateau[lesX1[0]][lesY1[0]] == BORDURE) // collision avec une bordure
-    {
-        *collision1 = true;
-    }
-    else if (plateau[lesX1[0]][lesY1[0]] == TETE_SERPENT_2 || plateau[lesX1[0]][lesY1[0]] == CORPS) // collision avec le serpent2 ou lui-même
-    {
-        *collision1 = true;
-    }
-
-    // Mise à jour du plateau avec les nouvelles positions
-    plateau[lesX1[0]][lesY1[0]] = TETE_SERPENT_1;
-    for (int i = 1; i < TAILLE; i++)
-    {
-        plateau[lesX1[i]][lesY1[i]] = CORPS;
-    }
-
-    // Dessiner le serpent à l'écran
-    dessinerSerpent1(lesX1, lesY1);
-}
-/************************************************
-	   FONCTIONS ET PROCEDURES DU SERPENT 2	    
-*************************************************/
-void dessinerSerpent2(int lesX2[], int lesY2[])
-{
-	int i;
-	// affiche les anneaux puis la tête
-	for(i = 1 ; i < TAILLE ; i++)
-	{
-		afficher(lesX2[i], lesY2[i], CORPS);
-	}
-	afficher(lesX2[0], lesY2[0], TETE_SERPENT_2);
-}
-
-void directionSerpent2(int lesX2[], int lesY2[], tPlateau plateau, char *direction2, int x, int y, int lesX1[], int lesY1[], char directionSerpent1)
+bool caseRivale(tPartie *partie, int iSerpent, int x, int y)
 {
-    // Calcul des directions possibles
-    int differenceX = x - lesX2[0]; // Différence en X
-    int differenceY = y - lesY2[0]; // Différence en Y
-    
-    // Tableau pour stocker les directions possibles sans collision
-    char directionsValides[4] = {HAUT, BAS, GAUCHE, DROITE};
-    bool directionValide[4] = {true, true, true, true}; // indique si la direction est valide
-    int nbDirectionsValides = 4;
-    
-    // Vérifier chaque direction possible
-    for(int i = 0; i < 4; i++)
+    // comme caseVisee, mais pour la tête de n'importe quel autre serpent en jeu
+    static const char lesDirections[4] = {HAUT, BAS, GAUCHE, DROITE};
+    for (int i = 0 ; i < partie->nbSerpents ; i++)
     {
-        if(verifierCollisionProchainDeplacement2(lesX2, lesY2, plateau, directionsValides[i], lesX1, lesY1, directionSerpent1)) {
-            directionValide[i] = false;
-            nbDirectionsValides--;
+        if (i == iSerpent || !partie->vivants[i])
+        {
+            continue;
         }
-    }
-    
-    // Si au moins une direction est valide
-    if(nbDirectionsValides > 0)
-    {
-        // Priorité à la direction qui rapproche de l'objectif
-        if(abs(differenceX) >= abs(differenceY))
+        for (int d = 0 ; d < 4 ; d++)
         {
-            // Essayer d'abord horizontal
-            if(differenceX > 0 && directionValide[3])
-            { // DROITE
-                *direction2 = DROITE;
-            } else if(differenceX < 0 && directionValide[2])
-            { // GAUCHE
-                *direction2 = GAUCHE;
-            }
-            // Si horizontal impossible, essayer vertical
-            else if(differenceY > 0 && directionValide[1])
-            { // BAS
-                *direction2 = BAS;
-            } else if(differenceY < 0 && directionValide[0])
-            { // HAUT
-                *direction2 = HAUT;
-            }
-            // Sinon prendre la première direction valide
-            else {
-                for(int i = 0; i < 4; i++)
-                {
-                    if(directionValide[i])
-                    {
-                        *direction2 = directionsValides[i];
-                        break;
-                    }
-                }
-            }
-        } else {
-            // Même quand la différence Y est plus grande, essayer d'abord horizontal
-            if(differenceX > 0 && directionValide[3])
-            { // DROITE
-                *direction2 = DROITE;
-            } else if(differenceX < 0 && directionValide[2])
-            { // GAUCHE
-                *direction2 = GAUCHE;
-            }
-            // Si horizontal impossible, essayer vertical
-            else if(differenceY > 0 && directionValide[1])
-            { // BAS
-                *direction2 = BAS;
-            } else if(differenceY < 0 && directionValide[0])
-            { // HAUT
-                *direction2 = HAUT;
-            }
-            // Sinon prendre la première direction valide
-            else {
-                for(int i = 0; i < 4; i++)
-                {
-                    if(directionValide[i])
-                    {
-                        *direction2 = directionsValides[i];
-                        break;
-                    }
-                }
+            int voisinX, voisinY;
+            caseVoisine(partie->tetesX[i], partie->tetesY[i], lesDirections[d], &voisinX, &voisinY);
+            if (voisinX == x && voisinY == y)
+            {
+                return true;
             }
         }
     }
-    // Si aucune direction n'est valide, on garde la direction actuelle
+    return false;
 }
 
-int calculDistance2(int lesX2[], int lesY2[], int pommeX, int pommeY)
+char directionRivale(tPartie *partie, int iSerpent)
 {
-    // définition des variables
-    int passageIssueGauche, passageIssueDroit, passageIssueHaut, passageIssueBas, passageDirect;
-
-    // Calcul des distances des chemins utilisant chaque issue et en allant directement par le plateau
-    passageIssueGauche = abs(lesX2[0] - ISSUE_GAUCHE_X) + abs(lesY2[0] - ISSUE_GAUCHE_Y) + 
-        abs(pommeX - ISSUE_DROITE_X) + abs(pommeY - ISSUE_DROITE_Y);
-    passageIssueDroit = abs(lesX2[0] - ISSUE_DROITE_X) + abs(lesY2[0] - ISSUE_DROITE_Y) + 
-        abs(pommeX - ISSUE_GAUCHE_X) + abs(pommeY - ISSUE_GAUCHE_Y);
-    passageIssueHaut = abs(lesX2[0] - ISSUE_HAUT_X) + abs(lesY2[0] - ISSUE_HAUT_Y) + 
-        abs(pommeX - ISSUE_BAS_X) + abs(pommeY - ISSUE_BAS_Y);
-    passageIssueBas = abs(lesX2[0] - ISSUE_BAS_X) + abs(lesY2[0] - ISSUE_BAS_Y) + 
-        abs(pommeX - ISSUE_HAUT_X) + abs(pommeY - ISSUE_HAUT_Y);
-    passageDirect = abs(lesX2[0] - pommeX) + abs(lesY2[0] - pommeY);
-
-
-    // compare les résultats pour obtenir le meilleur chemin
-    // chemin direct vers la pomme sans passer dans un trou
-    if (passageDirect < passageIssueHaut && passageDirect < passageIssueBas &&
-        passageDirect < passageIssueGauche && passageDirect < passageIssueDroit)
-    {
-        return CHEMIN_POMME;
-    }
-    // Privilégie d'abord les passages horizontaux
-    else if (passageIssueGauche <= passageIssueDroit)
-    {
-        return GAUCHE;
-    }
-    else if (passageIssueDroit <= passageIssueHaut && passageIssueDroit <= passageIssueBas)
-    {
-        return DROITE;
-    }
-    else if (passageIssueHaut <= passageIssueBas)
-    {
-        return HAUT;
-    }
-    else
+    // direction supposée d'un autre serpent pendant la recherche : la sienne si sa case
+    // suivante est libre (ni mur, ni serpent), sinon la première direction libre
+    char direction = partie->directions[iSerpent];
+    for (char essai = HAUT - 1 ; essai <= DROITE ; essai++)
     {
-        return BAS;
+        int x, y;
+        if (essai >= HAUT)
+        {
+            direction = essai;
+        }
+        caseVoisine(partie->tetesX[iSerpent], partie->tetesY[iSerpent], direction, &x, &y);
+        if (!lireBit(partie->murs, x, y) && !lireBit(partie->serpents, x, y))
+        {
+            return direction;
+        }
     }
+    return partie->directions[iSerpent];
 }
 
-bool verifierCollisionProchainDeplacement2(int lesX2[], int lesY2[], tPlateau plateau, char prochaineDirection2, int lesX1[], int lesY1[], char directionSerpent1)
+void progresserSerpents(tPartie *partie)
 {
-    int nouvelleX = lesX2[0];
-    int nouvelleY = lesY2[0];
-
-    // Calcul de la nouvelle position
-    switch (prochaineDirection2)
-    {
-        case HAUT:
-            nouvelleY--;
-            break;
-        case BAS:
-            nouvelleY++;
-            break;
-        case GAUCHE:
-            nouvelleX--;
-            break;
-        case DROITE:
-            nouvelleX++;
-            break;
-    }
-
-    // Prédiction de la prochaine position du serpent 1
-    int prochaineX1 = lesX1[0];
-    int prochaineY1 = lesY1[0];
-    switch (directionSerpent1)
-    {
-        case HAUT:
-            prochaineY1--;
-            break;
-        case BAS:
-            prochaineY1++;
-            break;
-        case GAUCHE:
-            prochaineX1--;
-            break;
-        case DROITE:
-            prochaineX1++;
-            break;
-    }
-
-    // Si la nouvelle position va créer une collision, éviter
-    if (nouvelleX == prochaineX1 && nouvelleY == prochaineY1)
+    /*
+    * déplace tous les serpents en jeu en même temps : les prochaines têtes de tous les
+    * serpents sont calculées, les queues libèrent leur case, puis chaque prochaine tête
+    * est comparée au plateau et aux autres prochaines têtes (deux têtes sur la même case
+    * sont toutes deux en collision). Les serpents sans collision avancent, les autres
+    * sont éliminés, et retirés du plateau si la partie continue
+    */
+    // déplacement en X et en Y de chaque direction (indice HAUT, BAS, GAUCHE ou DROITE)
+    static const int decalagesX[5] = {0, 0, 0, -1, 1};
+    static const int decalagesY[5] = {0, -1, 1, 0, 0};
+    int nbSerpents = partie->nbSerpents;
+    int *prochainesX = partie->prochainesX;
+    int *prochainesY = partie->prochainesY;
+    bool issue[NB_SERPENTS_MAX];
+    bool heurte[NB_SERPENTS_MAX];
+
+    noter(partie, prochainesX, (size_t)nbSerpents * sizeof(int));
+    noter(partie, prochainesY, (size_t)nbSerpents * sizeof(int));
+    // prochaine tête de chaque serpent, issues comprises : une seule boucle sans branchement
+    // sur les tableaux contigus des têtes et des directions
+    for (int i = 0 ; i < nbSerpents ; i++)
     {
-        return true;
+        int x = partie->tetesX[i] + decalagesX[(int)partie->directions[i]];
+        int y = partie->tetesY[i] + decalagesY[(int)partie->directions[i]];
+        prochainesX[i] = (x <= 0) ? LARGEUR_PLATEAU : ((x > LARGEUR_PLATEAU) ? 1 : x);
+        prochainesY[i] = (y <= 0) ? HAUTEUR_PLATEAU : ((y > HAUTEUR_PLATEAU) ? 1 : y);
+        issue[i] = (prochainesX[i] != x) || (prochainesY[i] != y);
     }
 
-    // Collision avec les bordures
-    if (plateau[nouvelleX][nouvelleY] == BORDURE)
+    // ajout d'un déplacement pour chaque serpent en jeu, dont la queue
+    // libère sa case (sauf si le serpent grandit)
+    for (int i = 0 ; i < nbSerpents ; i++)
     {
-        return true;
+        tCorps *corps = &partie->corps[i];
+        if (!partie->vivants[i])
+        {
+            continue;
+        }
+        noter(partie, &partie->deplacements[i], sizeof(int));
+        partie->deplacements[i]++;
+        if (corps->aGrandir == 0)
+        {
+            int xQueue = anneauX(corps, corps->longueur - 1);
+            int yQueue = anneauY(corps, corps->longueur - 1);
+            noter(partie, &partie->plateau[xQueue][yQueue], 1);
+            noterBit(partie, partie->serpents, xQueue, yQueue);
+            partie->plateau[xQueue][yQueue] = VIDE;
+            oterBit(partie->serpents, xQueue, yQueue);
+        }
     }
 
-    // Collision tête contre tête avec le serpent 1
-    if (nouvelleX == lesX1[0] && nouvelleY == lesY1[0])
-    {
-        return true;
-    }
+    mesurerPhase(partie, PHASE_PROGRESSION);
 
-    // Collision avec le corps des deux serpents
-    for (int i = 0; i < TAILLE; i++)
+    // Vérification des collisions : bordure, serpent déjà sur la case, ou autre tête
+    // arrivant sur la même case pendant ce déplacement
+    for (int i = 0 ; i < nbSerpents ; i++)
     {
-        if ((lesX2[i] == nouvelleX && lesY2[i] == nouvelleY) || 
-            (lesX1[i] == nouvelleX && lesY1[i] == nouvelleY))
+        heurte[i] = false;
+        if (!partie->vivants[i])
+        {
+            continue;
+        }
+        noter(partie, &partie->causes[i], sizeof(int));
+        if (lireBit(partie->murs, prochainesX[i], prochainesY[i])) // collision avec une bordure
         {
-            return true;
+            heurte[i] = true;
+            partie->causes[i] = CAUSE_BORDURE;
+        }
+        else if (lireBit(partie->serpents, prochainesX[i], prochainesY[i])) // collision avec un autre serpent ou lui-même
+        {
+            heurte[i] = true;
+            partie->causes[i] = caseOccupee(&partie->corps[i], prochainesX[i], prochainesY[i]) ? CAUSE_LUI_MEME : CAUSE_ADVERSAIRE;
+        }
+        else
+        {
+            bool memeCase = false;
+            for (int j = 0 ; j < nbSerpents ; j++)
+            {
+                memeCase |= (j != i) & partie->vivants[j] & (prochainesX[j] == prochainesX[i]) & (prochainesY[j] == prochainesY[i]);
+            }
+            if (memeCase) // collision tête contre tête
+            {
+                heurte[i] = true;
+                partie->causes[i] = CAUSE_ADVERSAIRE;
+            }
         }
     }
 
-    return false;
-}
-
-void progresser2(int lesX2[], int lesY2[], char direction2, tPlateau plateau, bool *collision2, bool *pommeMangee2, bool *utiliserIssue2)
-{
-    // ajout d'un déplacement pour le serpent 2
-	deplacements2++;
+    mesurerPhase(partie, PHASE_COLLISION);
 
-    // Effacer l'ancienne position du serpent dans le plateau donne le coté "avancer" au serpent
-    for (int i = 0; i < TAILLE; i++)
-    {
-        plateau[lesX2[i]][lesY2[i]] = VIDE;
-    }
-    plateau[lesX2[TAILLE - 1]][lesY2[TAILLE - 1]] = VIDE;
-    
-    // Effacer le dernier élément à l'écran
-    effacer(lesX2[TAILLE - 1], lesY2[TAILLE - 1]);
-
-    // Mettre à jour les positions
-    for (int i = TAILLE - 1; i > 0; i--)
-    {
-        lesX2[i] = lesX2[i - 1];
-        lesY2[i] = lesY2[i - 1];
-    }
-    
-    // Faire progresser la tête dans la nouvelle direction
-    switch (direction2)
+    // Seules trois cases du plateau changent par serpent : l'ancienne queue (déjà libérée),
+    // l'ancienne tête qui devient un anneau du corps et la nouvelle tête
+    noter(partie, &partie->mangeur, sizeof(int));
+    partie->mangeur = -1;
+    for (int i = 0 ; i < nbSerpents ; i++)
     {
-        case HAUT:
-            lesY2[0] = lesY2[0] - 1;
-            break;
-        case BAS:
-            lesY2[0] = lesY2[0] + 1;
-            break;
-        case DROITE:
-            lesX2[0] = lesX2[0] + 1;
-            break;
-        case GAUCHE:
-            lesX2[0] = lesX2[0] - 1;
-            break;
-    }
+        tCorps *corps = &partie->corps[i];
+        int xTete = prochainesX[i];
+        int yTete = prochainesY[i];
+        if (!partie->vivants[i] || heurte[i])
+        {
+            continue;
+        }
+        noter(partie, &partie->plateau[partie->tetesX[i]][partie->tetesY[i]], 1);
+        partie->plateau[partie->tetesX[i]][partie->tetesY[i]] = CORPS;
+
+        // Mettre à jour les positions : la nouvelle tête entre dans le tampon, la queue avance d'elle-même
+        noterAvancee(partie, corps, xTete, yTete);
+        noterBit(partie, partie->serpents, xTete, yTete);
+        noter(partie, &partie->tetesX[i], sizeof(int));
+        noter(partie, &partie->tetesY[i], sizeof(int));
+        noter(partie, &partie->utiliserIssues[i], sizeof(bool));
+        avancerCorps(corps, xTete, yTete);
+        poserBit(partie->serpents, xTete, yTete);
+        partie->tetesX[i] = xTete;
+        partie->tetesY[i] = yTete;
+        partie->utiliserIssues[i] = partie->utiliserIssues[i] || issue[i];
+
+        if (lireBit(partie->pommes, xTete, yTete)) // "collision" avec une pomme
+        {
+            noterBit(partie, partie->pommes, xTete, yTete);
+            oterBit(partie->pommes, xTete, yTete);
+            partie->mangeur = i;
+            corps->aGrandir += CROISSANCE;
+        }
 
-    // Gestion des passages par les issues
-    if (lesX2[0] <= 0) //issue gauche
-    {
-        lesX2[0] = LARGEUR_PLATEAU;
-        *utiliserIssue2 = true;
-    }
-    else if (lesX2[0] > LARGEUR_PLATEAU) // issue droite
-    {
-        lesX2[0] = 1;
-        *utiliserIssue2 = true;
-    }
-    else if (lesY2[0] <= 0) // issue bas
-    {
-        lesY2[0] = HAUTEUR_PLATEAU;
-        *utiliserIssue2 = true;
-    }
-    else if (lesY2[0] > HAUTEUR_PLATEAU) // issue haut
-    {
-        lesY2[0] = 1;
-        *utiliserIssue2 = true;
+        // Mise à jour du plateau avec la nouvelle tête
+        noter(partie, &partie->plateau[xTete][yTete], 1);
+        partie->plateau[xTete][yTete] = TETES_SERPENTS[i];
     }
 
-    *pommeMangee2 = false;
-    // Vérification des collisions et mise à jour du plateau
-    if (plateau[lesX2[0]][lesY2[0]] == POMME) // "collision" avec une pomme
-    {
-        *pommeMangee2 = true;
-        plateau[lesX2[0]][lesY2[0]] = VIDE;
-    }
-    else if (plateau[lesX2[0]][lesY2[0]] == BORDURE) // collsion avec une bordure
+    // élimination des serpents en collision
+    for (int i = 0 ; i < nbSerpents ; i++)
     {
-        *collision2 = true;
+        if (heurte[i])
+        {
+            noter(partie, &partie->vivants[i], sizeof(bool));
+            noter(partie, &partie->collisions[i], sizeof(bool));
+            noter(partie, &partie->nbVivants, sizeof(int));
+            partie->vivants[i] = false;
+            partie->collisions[i] = true;
+            partie->nbVivants--;
+        }
     }
-    else if (plateau[lesX2[0]][lesY2[0]] == TETE_SERPENT_1 || plateau[lesX2[0]][lesY2[0]] == CORPS) // collision avec le serpent 1 ou lui-même
+    if (partie->nbVivants >= partie->nbVivantsMin)
     {
-        *collision2 = true;
+        for (int i = 0 ; i < nbSerpents ; i++)
+        {
+            if (heurte[i])
+            {
+                retirerSerpent(partie, i);
+            }
+        }
     }
+}
 
-    // Mise à jour du plateau avec les nouvelles positions
-    plateau[lesX2[0]][lesY2[0]] = TETE_SERPENT_2;
-    for (int i = 1; i < TAILLE; i++)
+void retirerSerpent(tPartie *partie, int iSerpent)
+{
+    // libère les cases d'un serpent éliminé pour que les autres serpents continuent.
+    // Sa queue a déjà quitté sa case pendant ce déplacement, sauf s'il grandissait
+    tCorps *corps = &partie->corps[iSerpent];
+    int nbAnneaux = (corps->aGrandir == 0) ? corps->longueur - 1 : corps->longueur;
+    for (int i = 0 ; i < nbAnneaux ; i++)
     {
-        plateau[lesX2[i]][lesY2[i]] = CORPS;
+        noter(partie, &partie->plateau[anneauX(corps, i)][anneauY(corps, i)], 1);
+        noterBit(partie, partie->serpents, anneauX(corps, i), anneauY(corps, i));
+        partie->plateau[anneauX(corps, i)][anneauY(corps, i)] = VIDE;
+        oterBit(partie->serpents, anneauX(corps, i), anneauY(corps, i));
     }
-
-    // Dessiner le serpent à l'écran
-    dessinerSerpent2(lesX2, lesY2);
+    noter(partie, corps->occupation, sizeof(corps->occupation));
+    memset(corps->occupation, 0, sizeof(corps->occupation));
 }
 
 /************************************************
@@ -1045,80 +3045,136 @@ void gotoxy(int x, int y)
     printf("\033[%d;%df", y, x);
 }
 
-int kbhit()
+void demarrerClavier()
 {
-	// la fonction retourne :
-	// 1 si un caractere est present
-	// 0 si pas de caractere présent
-	int unCaractere = 0;
-	struct termios oldt, newt;
-	int ch;
-	int oldf;
+	// terminal sans écho ni attente de fin de ligne, réglé une seule fois, puis lancement
+	// du thread de lecture. Le terminal est remis en état à la sortie du programme et
+	// sur les signaux d'arrêt
+	struct termios brut;
+	struct sigaction action;
 
-	// mettre le terminal en mode non bloquant
-	tcgetattr(STDIN_FILENO, &oldt);
-	newt = oldt;
-	newt.c_lflag &= ~(ICANON | ECHO);
-	tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-	oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
-	fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
- 
-	ch = getchar();
-
-	// restaurer le mode du terminal
-	tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-	fcntl(STDIN_FILENO, F_SETFL, oldf);
- 
-	if(ch != EOF)
+	if (tcgetattr(STDIN_FILENO, &terminalInitial) == -1)
+	{
+		perror("tcgetattr");
+		exit(EXIT_FAILURE);
+	}
+	brut = terminalInitial;
+	brut.c_lflag &= ~(ICANON | ECHO);
+	brut.c_cc[VMIN] = 1;
+	brut.c_cc[VTIME] = 0;
+	if (tcsetattr(STDIN_FILENO, TCSANOW, &brut) == -1)
+	{
+		perror("tcsetattr");
+		exit(EXIT_FAILURE);
+	}
+	terminalModifie = 1;
+	atexit(restaurerTerminal);
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = signalArret;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	sigaction(SIGHUP, &action, NULL);
+	sigaction(SIGQUIT, &action, NULL);
+
+	atomic_store(&arretClavier, false);
+	if (pthread_create(&threadClavier, NULL, lireClavier, NULL) != 0)
 	{
-		ungetc(ch, stdin);
-		unCaractere = 1;
-	} 
-	return unCaractere;
+		perror("pthread_create");
+		exit(EXIT_FAILURE);
+	}
+	clavierDemarre = true;
 }
 
-// Fonction pour désactiver l'echo
-void disable_echo()
+void arreterClavier()
 {
-    struct termios tty;
+	// le thread voit la demande d'arrêt au plus tard ATTENTE_CLAVIER millisecondes après
+	if (clavierDemarre)
+	{
+		atomic_store(&arretClavier, true);
+		pthread_join(threadClavier, NULL);
+		clavierDemarre = false;
+	}
+	restaurerTerminal();
+}
 
-    // Obtenir les attributs du terminal
-    if (tcgetattr(STDIN_FILENO, &tty) == -1) 
+void restaurerTerminal()
+{
+	if (terminalModifie)
 	{
-        perror("tcgetattr");
-        exit(EXIT_FAILURE);
-    }
+		tcsetattr(STDIN_FILENO, TCSANOW, &terminalInitial);
+		terminalModifie = 0;
+	}
+}
+
+void signalArret(int numero)
+{
+	// tcsetattr peut être appelée dans un gestionnaire de signal ; le signal est ensuite
+	// renvoyé avec son traitement par défaut, le programme s'arrête donc comme avant
+	struct sigaction action;
+
+	restaurerTerminal();
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = SIG_DFL;
+	sigemptyset(&action.sa_mask);
+	sigaction(numero, &action, NULL);
+	raise(numero);
+}
 
-    // Désactiver le flag ECHO
-    tty.c_lflag &= ~ECHO;
+void *lireClavier(void *arg)
+{
+	// producteur de la file : attend une touche avec poll, la lit et la dépose
+	struct pollfd entree;
+	char touche;
+	int pret;
 
-    // Appliquer les nouvelles configurations
-    if (tcsetattr(STDIN_FILENO, TCSANOW, &tty) == -1)
+	(void)arg;
+	entree.fd = STDIN_FILENO;
+	entree.events = POLLIN;
+	while (!atomic_load(&arretClavier))
 	{
-        perror("tcsetattr");
-        exit(EXIT_FAILURE);
-    }
+		pret = poll(&entree, 1, ATTENTE_CLAVIER);
+		if (pret < 0 && errno != EINTR)
+		{
+			break;
+		}
+		if (pret > 0)
+		{
+			// 0 octet lu : fin de l'entrée standard, plus aucune touche n'arrivera
+			if (read(STDIN_FILENO, &touche, 1) != 1)
+			{
+				break;
+			}
+			deposerTouche(touche);
+		}
+	}
+	return NULL;
 }
 
-// Fonction pour réactiver l'echo
-void enable_echo()
+void deposerTouche(char touche)
 {
-    struct termios tty;
+	// file pleine (la boucle de jeu ne lit qu'une touche par tour) : la touche est perdue
+	unsigned int queue = atomic_load_explicit(&fileTouches.queue, memory_order_relaxed);
+	unsigned int tete = atomic_load_explicit(&fileTouches.tete, memory_order_acquire);
 
-    // Obtenir les attributs du terminal
-    if (tcgetattr(STDIN_FILENO, &tty) == -1)
+	if (queue - tete < TAILLE_FILE_TOUCHES)
 	{
-        perror("tcgetattr");
-        exit(EXIT_FAILURE);
-    }
+		fileTouches.touches[queue % TAILLE_FILE_TOUCHES] = touche;
+		atomic_store_explicit(&fileTouches.queue, queue + 1, memory_order_release);
+	}
+}
 
-    // Réactiver le flag ECHO
-    tty.c_lflag |= ECHO;
+bool lireTouche(char *touche)
+{
+	// consommateur de la file : retourne false, sans changer touche, si aucune touche n'attend
+	unsigned int tete = atomic_load_explicit(&fileTouches.tete, memory_order_relaxed);
+	unsigned int queue = atomic_load_explicit(&fileTouches.queue, memory_order_acquire);
 
-    // Appliquer les nouvelles configurations
-    if (tcsetattr(STDIN_FILENO, TCSANOW, &tty) == -1)
+	if (tete == queue)
 	{
-        perror("tcsetattr");
-        exit(EXIT_FAILURE);
-    }
+		return false;
+	}
+	*touche = fileTouches.touches[tete % TAILLE_FILE_TOUCHES];
+	atomic_store_explicit(&fileTouches.tete, tete + 1, memory_order_release);
+	return true;
 }
\ No newline at end of file